@@ -8,14 +8,22 @@
  *
  */
 
+#include <iostream>
+
 #include <BinaryData.h>
 #include <juce_core/juce_core.h>
 #include <juce_gui_basics/juce_gui_basics.h>
 
 #include "./core/AudioProcessor.h"
+#include "./core/Capture.h"
+#include "./core/Evaluation.h"
+#include "./core/FFTBackend.h"
+#include "./core/MappedAudioSource.h"
+#include "./core/Session.h"
 #include "./ui/CustomLookAndFeel.h"
 #include "./ui/MainComponent.h"
 #include "./util/Globals.h"
+#include "./util/Logger.h"
 
 // NOLINTBEGIN(readability-identifier-naming)
 namespace ProjectInfo {
@@ -40,20 +48,117 @@ public:
     bool moreThanOneInstanceAllowed() override { return true; }
 
     void initialise([[maybe_unused]] const juce::String &commandLine) override {
+        const auto params = getCommandLineParameterArray();
+
+        // Offline accuracy and latency evaluation, exits with non-zero status
+        // on regression.
+        if (params.contains("--evaluate")) {
+            const bool passed = anyMidi::runEvaluation(
+                juce::File::getCurrentWorkingDirectory().getChildFile(
+                    anyMidi::EVALUATION_BASELINE_FILENAME),
+                params.contains("--update-baseline"));
+            setApplicationReturnValue(passed ? 0 : 1);
+            quit();
+            return;
+        }
+
+        if (params.contains("--benchmark-fft")) {
+            anyMidi::printFFTBenchmark();
+            quit();
+            return;
+        }
+
+        if (params.contains("--benchmark-session")) {
+            anyMidi::printSessionBenchmark();
+            quit();
+            return;
+        }
+
+        // Replays a capture offline, defaulting to the file --capture writes.
+        const int replayIndex = params.indexOf("--replay");
+        if (replayIndex >= 0) {
+            const auto path = replayIndex + 1 < params.size()
+                                  ? params[replayIndex + 1]
+                                  : juce::String{anyMidi::CAPTURE_FILENAME};
+            const bool replayed = anyMidi::runReplay(
+                juce::File::getCurrentWorkingDirectory().getChildFile(path));
+            setApplicationReturnValue(replayed ? 0 : 1);
+            quit();
+            return;
+        }
+
+        // Transcribes a WAV recording into a MIDI file next to it, unless
+        // another output is given.
+        const int transcribeIndex = params.indexOf("--transcribe");
+        if (transcribeIndex >= 0 && transcribeIndex + 1 < params.size()) {
+            const auto cwd = juce::File::getCurrentWorkingDirectory();
+            const auto input = cwd.getChildFile(params[transcribeIndex + 1]);
+            const auto output =
+                transcribeIndex + 2 < params.size() &&
+                        !params[transcribeIndex + 2].startsWith("--")
+                    ? cwd.getChildFile(params[transcribeIndex + 2])
+                    : input.withFileExtension("mid");
+            const bool transcribed = anyMidi::runTranscription(input, output);
+            setApplicationReturnValue(transcribed ? 0 : 1);
+            quit();
+            return;
+        }
+
         const juce::ValueTree audioProcNode(anyMidi::AUDIO_PROC_ID);
         tree_.addChild(audioProcNode, -1, nullptr);
 
         const juce::ValueTree guiNode{anyMidi::GUI_ID};
         tree_.addChild(guiNode, -1, nullptr);
 
+        logDrainer_ = std::make_unique<anyMidi::LogDrainer>(tree_);
+        if (params.contains("--log-file")) {
+            logDrainer_->enableLogFile(
+                juce::File::getCurrentWorkingDirectory().getChildFile(
+                    anyMidi::LOG_FILENAME),
+                maxLogFileBytes, maxLogFiles);
+        }
+
+        // Instruments of a session file, or the single default instrument.
+        std::vector<anyMidi::InstrumentConfig> instruments;
+        const int sessionIndex = params.indexOf("--session");
+        if (sessionIndex >= 0) {
+            const auto file =
+                sessionIndex + 1 < params.size()
+                    ? juce::File::getCurrentWorkingDirectory().getChildFile(
+                          params[sessionIndex + 1])
+                    : juce::File{};
+            if (!anyMidi::loadSession(file, instruments)) {
+                std::cerr << "Failed to load session "
+                          << file.getFullPathName() << "\n";
+                setApplicationReturnValue(1);
+                quit();
+                return;
+            }
+        }
+
         audioProcessor_ = std::make_unique<anyMidi::AudioProcessor>(
-            anyMidi::defaultSampleRate, tree_);
+            anyMidi::defaultSampleRate, tree_, instruments);
+        if (params.contains("--capture")) {
+            audioProcessor_->startCapture(
+                juce::File::getCurrentWorkingDirectory().getChildFile(
+                    anyMidi::CAPTURE_FILENAME));
+        }
+        audioProcessor_->openAudioDevice();
+
+        // Runs until terminated, configured by the session file alone.
+        if (params.contains("--headless")) {
+            return;
+        }
+
         mainWindow_ = std::make_shared<MainWindow>(getApplicationName(),
                                                    &layout_, guiNode);
         tray_ = std::make_unique<anyMidi::TrayIcon>(mainWindow_.get());
     }
 
-    void shutdown() override { mainWindow_ = nullptr; }
+    void shutdown() override {
+        mainWindow_ = nullptr;
+        logDrainer_ = nullptr;
+    }
 
     void systemRequestedQuit() override { quit(); }
 
@@ -135,8 +240,13 @@ public:
     };
 
 private:
+    static constexpr juce::int64 maxLogFileBytes{1024 * 1024};
+    static constexpr int maxLogFiles{3};
+
     anyMidi::CustomLookAndFeel layout_;
 
+    std::unique_ptr<anyMidi::LogDrainer> logDrainer_;
+
     std::unique_ptr<anyMidi::AudioProcessor> audioProcessor_;
     std::shared_ptr<MainWindow> mainWindow_;
     std::unique_ptr<anyMidi::TrayIcon> tray_;
@@ -0,0 +1,458 @@
+/**
+ *
+ *  @file      AnalysisPipeline.cpp
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#include "AnalysisPipeline.h"
+
+namespace {
+double midiToFrequency(const int &note) {
+    // Tuning is unchangeable due to the MIDI protocol.
+    constexpr double tuning{440.0};
+    constexpr double a4{69.0};
+    constexpr double octave{12.0};
+
+    // Based on MIDI tuning standard
+    return std::pow(2, (note - a4) / octave) * tuning;
+}
+
+double frequencyToMidi(const double &frequency) {
+    constexpr double tuning{440.0};
+    constexpr double a4{69.0};
+    constexpr double octave{12.0};
+
+    return a4 + octave * std::log2(frequency / tuning);
+}
+} // namespace
+
+anyMidi::AnalysisPipeline::AnalysisPipeline(double sampleRate, int fftOrder)
+    : fft_{createForwardFFT(fftOrder, sampleRate,
+                            juce::dsp::WindowingFunction<float>::hamming)},
+      midiProc_{static_cast<unsigned int>(sampleRate)},
+      sampleRate_{sampleRate}, analysisSampleRate_{sampleRate} {
+    // Generate a list of frequencies corresponding to the 128 Midi notes
+    constexpr int midiUpperBound{140};
+    for (int i = 0; i < midiUpperBound; ++i) {
+        noteFrequencies_.push_back(midiToFrequency(i));
+    }
+    salience_.prepare(noteFrequencies_, fft_->getBinWidth(),
+                      fft_->getNumBins());
+    salience_.setNumHarmonics(numPartials_);
+
+    prepare(sampleRate);
+}
+
+void anyMidi::AnalysisPipeline::prepare(double sampleRate) {
+    sampleRate_ = sampleRate;
+
+    // Initializing highpass filter.
+    hiPassCoefficients_ =
+        juce::IIRCoefficients::makeHighPass(sampleRate_, lowCutFreq_);
+    hiPassFilter_.setCoefficients(hiPassCoefficients_);
+    hiPassFilter_.reset();
+    gate_.prepare(sampleRate_);
+}
+
+void anyMidi::AnalysisPipeline::processBlock(float *samples, int numSamples,
+                                             juce::MidiBuffer *collector) {
+    // Applies filter.
+    {
+        const ScopedStageTimer timer{telemetry_, Stage::Filter};
+        hiPassFilter_.processSamples(samples, numSamples);
+    }
+
+    analyseBlock(samples, numSamples, collector);
+}
+
+void anyMidi::AnalysisPipeline::analyseBlock(const float *samples,
+                                             int numSamples,
+                                             juce::MidiBuffer *collector) {
+    // Silence skips the FFT, salience and note decisions. The FIFO is still
+    // filled, so the frame that completes after the gate opens includes the
+    // whole attack.
+    fft_->setAnalysisEnabled(gate_.process(samples, numSamples));
+
+    // Puts samples into FFT fifo after processing. Every frame is analysed
+    // as soon as it is full, with the stream clock at the sample that
+    // completed it, so its MIDI messages get sample accurate offsets.
+    // The FFT takes the samples in runs, each ending at the sample that
+    // completes a frame or is due for a check of the sounding note.
+    int clocked{0};
+    int i{0};
+    while (i < numSamples) {
+        int run = numSamples - i;
+        if (slidingNote_ >= 0) {
+            run = std::min(run, slidingCountdown_);
+        }
+        const int pushed = fft_->pushSamples(samples + i, run);
+        i += pushed;
+
+        const bool frameReady = fft_->isNextFFTBlockReady();
+        if (slidingNote_ >= 0) {
+            // The sample completing a frame does not count down.
+            slidingCountdown_ -= frameReady ? pushed - 1 : pushed;
+        }
+
+        if (frameReady) {
+            midiProc_.advance(i - clocked);
+            clocked = i;
+            calcNote();
+            fft_->setNextFFTBlockReady(false);
+        } else if (slidingNote_ >= 0 && slidingCountdown_ == 0) {
+            slidingCountdown_ = slidingHop;
+            midiProc_.advance(i - clocked);
+            clocked = i;
+            trackSoundingNote();
+        }
+    }
+    midiProc_.advance(numSamples - clocked);
+
+    midiProc_.coalesceBuffer();
+
+    if (collector != nullptr) {
+        midiProc_.collectBuffer(*collector);
+    }
+
+    if (telemetry_ != nullptr) {
+        telemetry_->setMidiQueueDepth(midiProc_.getNumQueuedEvents());
+    }
+    {
+        const ScopedStageTimer timer{telemetry_, Stage::MidiSend};
+        midiProc_.pushBufferToOutput();
+    }
+}
+
+void anyMidi::AnalysisPipeline::release() {
+    midiProc_.turnOffAllMessages();
+    referenceNote_ = 0;
+    slidingNote_ = -1;
+    fft_->getSlidingDft().track(nullptr, 0);
+    smoother_.reset();
+}
+
+void anyMidi::AnalysisPipeline::takePendingEvents(AnalysisPipeline &other) {
+    midiProc_.takePendingMessages(other.midiProc_);
+}
+
+void anyMidi::AnalysisPipeline::setMidiOutput(juce::MidiOutput *output) {
+    midiProc_.setMidiOutput(output);
+}
+
+void anyMidi::AnalysisPipeline::setTelemetry(Telemetry *telemetry) {
+    telemetry_ = telemetry;
+    fft_->setTelemetry(telemetry);
+}
+
+void anyMidi::AnalysisPipeline::setAdaptiveWindow(bool enabled) {
+    adaptiveWindow_ = enabled;
+    if (!enabled) {
+        fft_->setFrameLength(fft_->getFFTSize());
+        referenceNote_ = 0;
+    }
+}
+
+void anyMidi::AnalysisPipeline::setIncrementalAnalysis(bool enabled) {
+    incrementalAnalysis_ = enabled;
+    referenceNote_ = 0;
+}
+
+void anyMidi::AnalysisPipeline::setSlidingTracking(bool enabled) {
+    slidingTracking_ = enabled;
+    slidingNote_ = -1;
+    fft_->getSlidingDft().track(nullptr, 0);
+}
+
+void anyMidi::AnalysisPipeline::setSmoothingLag(int frames) {
+    smoother_.setLag(frames);
+    referenceNote_ = 0;
+}
+
+void anyMidi::AnalysisPipeline::setSpectrumPublisher(
+    SpectrumPublisher *publisher) {
+    spectrum_ = publisher;
+}
+
+double anyMidi::AnalysisPipeline::getAttackThreshold() const {
+    return midiProc_.getAttackThreshold();
+}
+
+double anyMidi::AnalysisPipeline::getReleaseThreshold() const {
+    return midiProc_.getReleaseThreshold();
+}
+
+int anyMidi::AnalysisPipeline::getWindowingFunction() const {
+    return fft_->getWindowingFunction();
+}
+
+juce::Array<juce::String>
+anyMidi::AnalysisPipeline::getAvailableWindowingMethods() const {
+    return fft_->getAvailableWindowingMethods();
+}
+
+void anyMidi::AnalysisPipeline::setAttackThreshold(double t) {
+    midiProc_.setAttackThreshold(t);
+}
+
+void anyMidi::AnalysisPipeline::setReleaseThreshold(double t) {
+    midiProc_.setReleaseThreshold(t);
+}
+
+void anyMidi::AnalysisPipeline::setNumPartials(int n) {
+    numPartials_ = n;
+    salience_.setNumHarmonics(n);
+    referenceNote_ = 0;
+}
+
+void anyMidi::AnalysisPipeline::setLowCutFrequency(double f) {
+    lowCutFreq_ = f;
+    hiPassCoefficients_ =
+        juce::IIRCoefficients::makeHighPass(sampleRate_, lowCutFreq_);
+    hiPassFilter_.setCoefficients(hiPassCoefficients_);
+}
+
+void anyMidi::AnalysisPipeline::setMpeEnabled(bool enabled) {
+    midiProc_.setMpeEnabled(enabled);
+}
+
+void anyMidi::AnalysisPipeline::setWindowingFunction(int id) {
+    fft_->setWindowingFunction(id);
+    referenceNote_ = 0;
+}
+
+void anyMidi::AnalysisPipeline::calcNote() {
+    int note{0};
+    double amp{0.0};
+    double pitch{0.0};
+
+    // A smoothed decision belongs to an earlier frame, so it cannot stand
+    // for this one, and the smoother must see every frame.
+    float gain{1.0F};
+    if (incrementalAnalysis_ && smoother_.getLag() == 0 && referenceNote_ > 0 &&
+        reusedFrames_ < maxReusedFrames &&
+        fft_->measureChange(gain) < stationaryThreshold) {
+        // The spectrum has only changed level since the last analysed frame,
+        // so its note and pitch stand. Bends in between are followed by the
+        // sliding DFT.
+        ++reusedFrames_;
+        note = referenceNote_;
+        amp = referenceAmp_ * gain;
+        pitch = referencePitch_;
+        fillSnapshot();
+    } else {
+        auto noteInfo = analyzeHarmonics(); // Gets {note, amplitude}
+        note = noteInfo.first;
+        amp = noteInfo.second;
+
+        // Fine pitch of the analysed note, for bends and vibrato.
+        pitch = static_cast<double>(note);
+        {
+            const ScopedStageTimer timer{telemetry_, Stage::PitchTracking};
+            if (note > 0) {
+                pitch = frequencyToMidi(fft_->estimateFrequency(
+                    noteFrequencies_[note], trackedHarmonics));
+            }
+        }
+
+        fft_->keepAsReference();
+        referenceNote_ = note;
+        referenceAmp_ = amp;
+        referencePitch_ = pitch;
+        reusedFrames_ = 0;
+    }
+
+    decideNote(note, pitch, amp);
+
+    if (adaptiveWindow_) {
+        adaptFrameLength(note, amp);
+    }
+
+    if (slidingTracking_) {
+        followSoundingNote(note, amp);
+    }
+
+    if (spectrum_ != nullptr) {
+        // Completes the snapshot started by analyzeHarmonics().
+        auto &snapshot = spectrum_->getWriteBuffer();
+        // Note 0 is what the analysis returns when nothing is detected.
+        snapshot.note = note > 0 ? note : -1;
+        snapshot.amplitude = static_cast<float>(amp);
+        snapshot.noteOn = midiProc_.isNoteOn();
+        snapshot.frame = ++spectrumFrame_;
+        spectrum_->publish();
+    }
+}
+
+void anyMidi::AnalysisPipeline::decideNote(int note, double pitch,
+                                           double amp) {
+    const ScopedStageTimer timer{telemetry_, Stage::NoteDecision};
+    const int velocity = static_cast<int>(std::round(amp * 127));
+
+    NoteChanges noteValues;
+    if (midiProc_.determineNoteValue(note, pitch, amp, noteValues)) {
+        for (const auto &newNote : noteValues) {
+            if (newNote.second) {
+                midiProc_.createMidiMsg(newNote.first,
+                                        static_cast<juce::uint8>(velocity),
+                                        newNote.second);
+            } else {
+                midiProc_.createMidiMsg(newNote.first, 0, newNote.second);
+            }
+        }
+    }
+    midiProc_.updateExpression(pitch, amp);
+}
+
+void anyMidi::AnalysisPipeline::followSoundingNote(int note, double amp) {
+    auto &sliding = fft_->getSlidingDft();
+    const int active = getNoteTracker().getActiveNote();
+
+    if (active != slidingNote_) {
+        slidingNote_ = active;
+        slidingCountdown_ = slidingHop;
+
+        std::array<int, SlidingDft::maxPartials> bins{};
+        int numBins{0};
+        if (active >= 0) {
+            for (unsigned int h = 1; h <= trackedHarmonics; ++h) {
+                const auto bin = static_cast<int>(std::round(
+                    noteFrequencies_[active] * h / fft_->getBinWidth()));
+                // Only the lower half holds the spectrum of a real signal.
+                if (bin >= 1 && bin < fft_->getFFTSize() / 2 - 1) {
+                    bins[numBins++] = bin;
+                }
+            }
+        }
+        sliding.track(bins.data(), numBins);
+    }
+
+    if (active < 0 || note != active) {
+        return;
+    }
+
+    double magnitude{0.0};
+    for (int p = 0; p < sliding.getNumPartials(); ++p) {
+        magnitude += sliding.getMagnitude(p);
+    }
+    slidingScale_ = magnitude > 0.0 ? amp / magnitude : 0.0;
+}
+
+void anyMidi::AnalysisPipeline::trackSoundingNote() {
+    const auto &sliding = fft_->getSlidingDft();
+    if (sliding.getNumPartials() == 0) {
+        return;
+    }
+
+    double magnitude{0.0};
+    int loudest{0};
+    for (int p = 0; p < sliding.getNumPartials(); ++p) {
+        const float m = sliding.getMagnitude(p);
+        magnitude += m;
+        if (m > sliding.getMagnitude(loudest)) {
+            loudest = p;
+        }
+    }
+    const double amp = magnitude * slidingScale_;
+
+    // The loudest harmonic gives the steadiest phase.
+    const double pitch = frequencyToMidi(sliding.getFrequency(loudest) *
+                                         fft_->getBinWidth() / (loudest + 1));
+
+    if (amp < getReleaseThreshold()) {
+        decideNote(slidingNote_, pitch, amp);
+        if (getNoteTracker().getActiveNote() < 0) {
+            slidingNote_ = -1;
+            fft_->getSlidingDft().track(nullptr, 0);
+        }
+    } else {
+        const ScopedStageTimer timer{telemetry_, Stage::NoteDecision};
+        midiProc_.updateExpression(pitch, amp);
+    }
+}
+
+std::pair<int, double> anyMidi::AnalysisPipeline::analyzeHarmonics() {
+    const float *spectrum = fft_->getCleanSpectrum();
+
+    int note{0};
+    {
+        const ScopedStageTimer timer{telemetry_, Stage::Salience};
+        note = salience_.process(spectrum);
+        if (smoother_.getLag() > 0) {
+            note = smoother_.process(salience_.getScores());
+        }
+    }
+
+    // The peaks of the frame, for the partials shown by the visualizer.
+    const int numHarmonics = salience_.getNumHarmonics();
+    fft_->findPeaks(note > 0 ? noteFrequencies_[note] : 0.0, numHarmonics);
+
+    const auto fftSize = static_cast<double>(fft_->getFFTSize());
+    double totalAmp{0.0};
+    double noiseAmp{0.0};
+
+    // Amps of the winner's harmonics added together to represent true
+    // amplitude. Only the part above the noise floor counts towards the
+    // thresholds.
+    for (int h = 0; h < numHarmonics; ++h) {
+        const double amp = salience_.getHarmonicMagnitude(note, h) / fftSize;
+        totalAmp += amp;
+        if (amp > 0.0) {
+            noiseAmp +=
+                fft_->getNoiseAmplitude(noteFrequencies_[note] * (h + 1));
+        }
+    }
+
+    fillSnapshot();
+
+    return {note, std::max(totalAmp - noiseAmp, 0.0)};
+}
+
+void anyMidi::AnalysisPipeline::adaptFrameLength(int note, double amp) {
+    int length = fft_->getFFTSize();
+    if (note > 0 && amp >= getReleaseThreshold()) {
+        // Period in samples, in the bin layout of the FFT.
+        const double period = fft_->getFFTSize() * fft_->getBinWidth() /
+                              noteFrequencies_[note];
+        length = static_cast<int>(std::ceil(periodsPerFrame * period));
+    }
+
+    const int previous = fft_->getFrameLength();
+    fft_->setFrameLength(length);
+    if (fft_->getFrameLength() != previous) {
+        // Spectra of different lengths are not comparable.
+        referenceNote_ = 0;
+    }
+}
+
+void anyMidi::AnalysisPipeline::fillSnapshot() {
+    if (spectrum_ == nullptr) {
+        return;
+    }
+
+    // Spectrum and partials for the visualizer. Published in calcNote().
+    auto &snapshot = spectrum_->getWriteBuffer();
+    snapshot.numBins = std::min(static_cast<std::size_t>(fft_->getNumBins()),
+                                SpectrumSnapshot::maxBins);
+    std::copy_n(fft_->getMagnitudes(), snapshot.numBins,
+                snapshot.magnitudes.begin());
+    snapshot.binWidth = fft_->getBinWidth();
+
+    const auto &peaks = fft_->getPeaks();
+    const float *frequencies = peaks.getFrequencies();
+    const float *amplitudes = peaks.getAmplitudes();
+    const int *harmonics = peaks.getHarmonics();
+    const int numHarmonics = salience_.getNumHarmonics();
+    snapshot.numPartials = 0;
+    for (int i = 0; i < peaks.size() &&
+                    snapshot.numPartials < SpectrumSnapshot::maxPartials;
+         ++i) {
+        if (harmonics[i] > 0 && harmonics[i] <= numHarmonics) {
+            snapshot.partialFrequencies[snapshot.numPartials] = frequencies[i];
+            snapshot.partialAmplitudes[snapshot.numPartials] = amplitudes[i];
+            ++snapshot.numPartials;
+        }
+    }
+}
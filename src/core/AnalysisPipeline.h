@@ -0,0 +1,286 @@
+/**
+ *
+ *  @file      AnalysisPipeline.h
+ *  @brief     Device independent chain from audio samples to MIDI notes.
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_core/juce_core.h>
+
+#include "ForwardFFT.h"
+#include "MidiProcessor.h"
+#include "NoteSmoother.h"
+#include "Salience.h"
+#include "SilenceGate.h"
+#include "SpectrumSnapshot.h"
+#include "Telemetry.h"
+
+namespace anyMidi {
+
+/**
+ *
+ *  @class   AnalysisPipeline
+ *  @brief   Filters incoming samples, runs the FFT and harmonic analysis, and
+ *           decides which MIDI notes to send. Knows nothing about audio
+ *           devices, so it can be driven by the audio callback as well as
+ *           offline from rendered or recorded audio.
+ *
+ */
+class AnalysisPipeline {
+public:
+    static constexpr double lowFilterFreq{75.0}; // E5 on guitar ~82 Hz
+    static constexpr double highFilterFreq{24000.0};
+
+    /// Optimized number of partials for the BSc project
+    static constexpr int defaultNumPartials{6};
+
+    /// Harmonics used to refine the pitch of a detected note.
+    static constexpr unsigned int trackedHarmonics{4};
+
+    /**
+     *  @brief AnalysisPipeline object constructor.
+     *  @param sampleRate - Sample rate of the stream.
+     *  @param fftOrder   - Base 2 logarithm of the FFT size, from
+     *                      ForwardFFT::minOrder to ForwardFFT::maxOrder.
+     *                      Larger sizes resolve lower notes, smaller ones
+     *                      respond sooner.
+     */
+    explicit AnalysisPipeline(double sampleRate,
+                              int fftOrder = ForwardFFT::defaultOrder);
+
+    /**
+     *  @brief Resets the filter state before a new stream of samples.
+     *  @param sampleRate - Sample rate of the stream.
+     */
+    void prepare(double sampleRate);
+
+    /**
+     *  @brief Processes one block of mono samples. The samples are filtered
+     *         in place. While the input is silent, frames are not analysed.
+     *  @param samples    - Block of samples.
+     *  @param numSamples - Number of samples in the block.
+     *  @param collector  - Optional buffer the block's MIDI events are added
+     *                      to, positioned by offset into the block. Events
+     *                      of a frame are placed just after the sample that
+     *                      completed it, so offsets run up to numSamples.
+     *                      Events from between blocks are placed at 0.
+     */
+    void processBlock(float *samples, int numSamples,
+                      juce::MidiBuffer *collector = nullptr);
+
+    /**
+     *  @brief Analyses a block that has already been filtered with the
+     *         pipeline's high-pass coefficients, for callers that filter
+     *         many pipelines' input together. Otherwise as processBlock().
+     */
+    void analyseBlock(const float *samples, int numSamples,
+                      juce::MidiBuffer *collector = nullptr);
+
+    /**
+     *  @brief High-pass filter processBlock() applies, for the sample rate
+     *         and low cut frequency.
+     */
+    const juce::IIRCoefficients &getHighPassCoefficients() const {
+        return hiPassCoefficients_;
+    }
+
+    /**
+     *  @brief Turns off any sounding note. Without a MIDI output the note offs
+     *         go to the collector of the next block.
+     */
+    void release();
+
+    /**
+     *  @brief Takes over the MIDI events a replaced pipeline has not handed
+     *         on, such as the note offs of its release(). Real-time safe.
+     */
+    void takePendingEvents(AnalysisPipeline &other);
+
+    void setMidiOutput(juce::MidiOutput *output);
+
+    void setTelemetry(Telemetry *telemetry);
+
+    /**
+     *  @brief Sample rate the FFT bins and MIDI timing were laid out for at
+     *         construction. A stream at another rate needs a new pipeline.
+     */
+    double getAnalysisSampleRate() const { return analysisSampleRate_; }
+
+    /**
+     *  @brief Samples per full frame, which is also the latency of a note.
+     */
+    int getFFTSize() const { return fft_->getFFTSize(); }
+
+    juce::String getFFTBackendName() const { return fft_->getBackendName(); }
+
+    /**
+     *  @brief Note decision state, for tuning hysteresis and minimum note
+     *         durations.
+     */
+    NoteTracker &getNoteTracker() { return midiProc_.getNoteTracker(); }
+
+    void setSpectrumPublisher(SpectrumPublisher *publisher);
+
+    /**
+     *  @brief Turns shortening the frames for high notes on or off. While
+     *         on, frames after one that found a note are only as long as
+     *         periodsPerFrame periods of it, rounded up to a supported
+     *         length, so they come sooner. Silence and low notes return to
+     *         full frames.
+     */
+    void setAdaptiveWindow(bool enabled);
+
+    bool isAdaptiveWindowEnabled() const { return adaptiveWindow_; }
+
+    /**
+     *  @brief Turns reusing the last analysis on or off. While on, a frame
+     *         whose spectrum differs from the last fully analysed one by
+     *         less than stationaryThreshold, apart from its level, keeps
+     *         that frame's note and pitch. Only its amplitude is updated, by
+     *         the change of level. Every maxReusedFrames frames are analysed
+     *         in full regardless, and every frame while smoothing is on.
+     */
+    void setIncrementalAnalysis(bool enabled);
+
+    bool isIncrementalAnalysisEnabled() const { return incrementalAnalysis_; }
+
+    /**
+     *  @brief Turns following the sounding note between frames on or off.
+     *         While on, its harmonics are tracked by a sliding DFT, so it is
+     *         released and its expression updated every slidingHop samples
+     *         instead of once per frame.
+     */
+    void setSlidingTracking(bool enabled);
+
+    bool isSlidingTrackingEnabled() const { return slidingTracking_; }
+
+    /**
+     *  @brief Sets how many frames the note decision waits for, see
+     *         NoteSmoother. Every frame of lag smooths out more glitches and
+     *         octave errors, but delays the notes by another frame. 0 turns
+     *         smoothing off, deciding each frame on its own.
+     */
+    void setSmoothingLag(int frames);
+
+    int getSmoothingLag() const { return smoother_.getLag(); }
+
+    double getAttackThreshold() const;
+    double getReleaseThreshold() const;
+    int getNumPartials() const { return numPartials_; }
+    double getLowCutFrequency() const { return lowCutFreq_; }
+    int getWindowingFunction() const;
+    juce::Array<juce::String> getAvailableWindowingMethods() const;
+    bool isMpeEnabled() const { return midiProc_.isMpeEnabled(); }
+
+    void setAttackThreshold(double t);
+    void setReleaseThreshold(double t);
+    void setNumPartials(int n);
+    void setLowCutFrequency(double f);
+    void setMpeEnabled(bool enabled);
+    void setWindowingFunction(int id);
+
+private:
+    std::unique_ptr<anyMidi::ForwardFFT> fft_;
+    anyMidi::MidiProcessor midiProc_;
+    anyMidi::Salience salience_;
+    anyMidi::NoteSmoother smoother_;
+    anyMidi::SilenceGate gate_;
+    juce::IIRFilter hiPassFilter_;
+    juce::IIRCoefficients hiPassCoefficients_;
+
+    double sampleRate_;
+    const double analysisSampleRate_;
+    double lowCutFreq_{lowFilterFreq};
+
+    int numPartials_{defaultNumPartials};
+    std::vector<double> noteFrequencies_; /// Lookup array to determine Midi
+                                          /// notes from frequencies.
+
+    Telemetry *telemetry_{nullptr};
+    SpectrumPublisher *spectrum_{nullptr};
+    juce::uint32 spectrumFrame_{0};
+
+    /// Periods of a note a shortened frame holds, enough for the harmonics
+    /// to be resolved by the window.
+    static constexpr double periodsPerFrame{4.0};
+    bool adaptiveWindow_{false};
+
+    /// Largest spectral change, see ForwardFFT::measureChange(), that
+    /// reuses the last analysis.
+    static constexpr float stationaryThreshold{0.15F};
+    static constexpr int maxReusedFrames{8};
+    bool incrementalAnalysis_{false};
+    /// Decision of the last fully analysed frame. Note 0 forces the next
+    /// frame to be analysed in full.
+    int referenceNote_{0};
+    double referenceAmp_{0.0};
+    double referencePitch_{0.0};
+    int reusedFrames_{0};
+
+    /// Samples between checks of the sounding note by the sliding DFT.
+    static constexpr int slidingHop{16};
+    bool slidingTracking_{true};
+    /// Note whose harmonics the sliding DFT tracks, -1 for none.
+    int slidingNote_{-1};
+    /// Note amplitude per unit of sliding DFT magnitude, measured at the
+    /// last frame that analysed the sounding note.
+    double slidingScale_{0.0};
+    int slidingCountdown_{slidingHop};
+
+    /**
+     *  @brief Creates a MIDI message with note value and amplitude retrieved
+     * from FFT analysis.
+     */
+    void calcNote();
+
+    /**
+     *  @brief Sets the length of the next frames from the note analysed in
+     *         this one.
+     */
+    void adaptFrameLength(int note, double amp);
+
+    /**
+     *  @brief Copies the frame's spectrum and the partials of its peak table
+     *         into the visualizer snapshot. Published in calcNote().
+     */
+    void fillSnapshot();
+
+    /**
+     *  @brief Passes the analysis of a frame, or of the sliding DFT, to the
+     *         note tracker and creates the MIDI messages it decides on.
+     */
+    void decideNote(int note, double pitch, double amp);
+
+    /**
+     *  @brief Points the sliding DFT at the sounding note's harmonics when
+     *         it changes, and rescales it to the frame's amplitude.
+     *  @param note - Note analysed in the frame.
+     *  @param amp  - Amplitude of the note in the frame.
+     */
+    void followSoundingNote(int note, double amp);
+
+    /**
+     *  @brief Releases the sounding note once the sliding DFT has it below
+     *         the release threshold, and updates its expression otherwise.
+     */
+    void trackSoundingNote();
+
+    /**
+     *  @brief  Determines a signals note value as the candidate with the
+     *          highest harmonic sum salience over the gated spectrum, and
+     *          builds the frame's peak table for it.
+     *  @retval  - A pair of the estimated note value with its summed signal
+     *             amplitude above the noise floor.
+     */
+    std::pair<int, double> analyzeHarmonics();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AnalysisPipeline)
+};
+
+} // namespace anyMidi
@@ -7,83 +7,82 @@
  *
  */
 
+#include <algorithm>
+
 #include "AudioProcessor.h"
 #include "../util/Globals.h"
-
-namespace {
-double midiToFrequency(const int &note) {
-    // Tuning is unchangeable due to the MIDI protocol.
-    constexpr double tuning{440.0};
-    constexpr double a4{69.0};
-    constexpr double octave{12.0};
-
-    // Based on MIDI tuning standard
-    return std::pow(2, (note - a4) / octave) * tuning;
-}
-} // namespace
-
-anyMidi::AudioProcessor::AudioProcessor(double sampleRate,
-                                        const juce::ValueTree &v)
-    : fft_{sampleRate, juce::dsp::WindowingFunction<float>::hamming},
-      deviceManager_{new anyMidi::AudioDeviceManagerRCO()},
-      midiProc_{static_cast<unsigned int>(sampleRate),
-                juce::Time::getMillisecondCounterHiRes() * msToSec},
-      tree_{v} {
-    // Some platforms require permissions to open input channels so requesting
-    // this here.
-    if (juce::RuntimePermissions::isRequired(
-            juce::RuntimePermissions::recordAudio) &&
-        !juce::RuntimePermissions::isGranted(
-            juce::RuntimePermissions::recordAudio)) {
-        juce::RuntimePermissions::request(
-            juce::RuntimePermissions::recordAudio, [&](bool granted) {
-                setAudioChannels(granted ? numInputChannels : 0,
-                                 numOutputChannels);
-            });
-    } else {
-        const juce::File deviceSettingsFile =
-            juce::File::getCurrentWorkingDirectory().getChildFile(
-                anyMidi::AUDIO_SETTINGS_FILENAME);
-
-        if (deviceSettingsFile.existsAsFile()) {
-            // Loads settings from file if it exists.
-            const auto storedSettings = juce::parseXML(deviceSettingsFile);
-            setAudioChannels(numInputChannels, numOutputChannels,
-                             storedSettings.get());
-        } else {
-            setAudioChannels(numInputChannels, numOutputChannels);
-        }
+#include "../util/Logger.h"
+
+anyMidi::AudioProcessor::AudioProcessor(
+    double sampleRate, const juce::ValueTree &v,
+    const std::vector<InstrumentConfig> &instruments)
+    : deviceManager_{new anyMidi::AudioDeviceManagerRCO()}, tree_{v},
+      startTicks_{juce::Time::getHighResolutionTicks()} {
+    auto audioProcNode = tree_.getChildWithName(anyMidi::AUDIO_PROC_ID);
+
+    // Without a session, the app serves one instrument on the first input,
+    // with the virtual port named after the app.
+    auto configs = instruments;
+    if (configs.empty()) {
+        configs.push_back({anyMidi::VIRTUAL_MIDI_PORT_NAME, 0, {}, {}});
     }
 
-    // Generate a list of frequencies corresponding to the 128 Midi notes
-    constexpr int midiUpperBound{140};
-    for (int i = 0; i < midiUpperBound; ++i) {
-        noteFrequencies_.push_back(midiToFrequency(i));
+    for (const auto &config : configs) {
+        juce::ValueTree instrumentNode{anyMidi::INSTRUMENT_ID};
+        audioProcNode.addChild(instrumentNode, -1, nullptr);
+
+        auto slot = std::make_unique<InstrumentSlot>(config, sampleRate,
+                                                     instrumentNode);
+        slot->setTelemetry(telemetry_.get());
+        numInputChannels_ = std::max(
+            numInputChannels_,
+            static_cast<unsigned int>(std::max(config.inputChannel, 0)) + 1);
+        slots_.push_back(std::move(slot));
     }
 
-    // Adding device manager to ValueTree so AudioDeviceSelectorComponent in GUI
-    // can access it. No listeners needed since pointer to device manager is
-    // received by GUI.
+    highPass_.prepare(static_cast<int>(slots_.size()));
+    slotSamples_.resize(slots_.size());
+
+    // The visualizer shows the instrument the GUI edits.
+    slots_.front()->setSpectrumPublisher(spectrum_.get());
+    auto &pipeline = slots_.front()->getPipeline();
+
+    // Telemetry and spectrum are shared through the ValueTree, for the debug
+    // and visualizer pages to display. The device manager is added once the
+    // device is open.
     tree_.getChildWithName(anyMidi::AUDIO_PROC_ID)
-        .setProperty(anyMidi::DEVICE_MANAGER_ID, deviceManager_.getObject(),
-                     nullptr);
+        .setProperty(anyMidi::TELEMETRY_ID, telemetry_.get(), nullptr);
+    tree_.getChildWithName(anyMidi::AUDIO_PROC_ID)
+        .setProperty(anyMidi::SPECTRUM_ID, spectrum_.get(), nullptr);
 
     auto guiNode = tree_.getChildWithName(anyMidi::GUI_ID);
     guiNode.setProperty(anyMidi::ATTACK_THRESH_ID,
-                        midiProc_.getAttackThreshold(), nullptr);
+                        pipeline.getAttackThreshold(), nullptr);
     guiNode.setProperty(anyMidi::RELEASE_THRESH_ID,
-                        midiProc_.getReleaseThreshold(), nullptr);
-    guiNode.setProperty(anyMidi::PARTIALS_ID, numPartials_, nullptr);
-    guiNode.setProperty(anyMidi::LO_CUT_ID, lowFilterFreq, nullptr);
-    guiNode.setProperty(anyMidi::HI_CUT_ID, highFilterFreq, nullptr);
-
-    guiNode.setProperty(anyMidi::CURRENT_WIN_ID, fft_.getWindowingFunction(),
+                        pipeline.getReleaseThreshold(), nullptr);
+    guiNode.setProperty(anyMidi::PARTIALS_ID, pipeline.getNumPartials(),
+                        nullptr);
+    guiNode.setProperty(anyMidi::LO_CUT_ID, pipeline.getLowCutFrequency(),
+                        nullptr);
+    guiNode.setProperty(anyMidi::HI_CUT_ID, AnalysisPipeline::highFilterFreq,
                         nullptr);
+    guiNode.setProperty(anyMidi::MPE_ID, pipeline.isMpeEnabled(), nullptr);
+    guiNode.setProperty(anyMidi::ADAPTIVE_WINDOW_ID,
+                        pipeline.isAdaptiveWindowEnabled(), nullptr);
+    guiNode.setProperty(anyMidi::SMOOTHING_LAG_ID, pipeline.getSmoothingLag(),
+                        nullptr);
+    guiNode.setProperty(anyMidi::INCREMENTAL_ANALYSIS_ID,
+                        pipeline.isIncrementalAnalysisEnabled(), nullptr);
+    guiNode.setProperty(anyMidi::SLIDING_TRACKING_ID,
+                        pipeline.isSlidingTrackingEnabled(), nullptr);
+
+    guiNode.setProperty(anyMidi::CURRENT_WIN_ID,
+                        pipeline.getWindowingFunction(), nullptr);
 
     juce::ValueTree winNode{anyMidi::ALL_WIN_ID};
     guiNode.addChild(winNode, -1, nullptr);
 
-    auto win = fft_.getAvailableWindowingMethods();
+    auto win = pipeline.getAvailableWindowingMethods();
     for (const auto &w : win) {
         juce::ValueTree winItemNode{anyMidi::WIN_NODE_ID};
         winNode.addChild(
@@ -96,164 +95,347 @@ anyMidi::AudioProcessor::AudioProcessor(double sampleRate,
 }
 
 anyMidi::AudioProcessor::~AudioProcessor() {
+    // The opener holds the message thread while it opens the device, so it
+    // is either done or gives up waiting for it.
+    if (deviceOpener_ != nullptr) {
+        deviceOpener_->stopThread(-1);
+    }
+
+    deviceManager_->removeChangeListener(this);
     audioSourcePlayer_.setSource(nullptr);
     deviceManager_->removeAudioCallback(&audioSourcePlayer_);
     deviceManager_ = nullptr;
+    capture_.stop();
+
+    // Slots are freed with their pipelines once no rebuild refers to them.
+    stopTimer();
+    pipelineBuilder_.removeAllJobs(false, -1);
+    slots_.clear();
+
+    // Pending jobs would be dropped by the pool's destructor, but a stalled
+    // disk must not keep the app from quitting.
+    const auto deadline =
+        juce::Time::getMillisecondCounter() + settingsWriteTimeoutMs;
+    while (pendingSettingsWrites_.load() > 0) {
+        const auto now = juce::Time::getMillisecondCounter();
+        if (now >= deadline ||
+            !settingsWritten_.wait(static_cast<double>(deadline - now))) {
+            anyMidi::log(LogLevel::Warning,
+                         "Gave up waiting for audio device settings to be "
+                         "written");
+            break;
+        }
+    }
+}
+
+void anyMidi::AudioProcessor::openAudioDevice() {
+    for (auto &slot : slots_) {
+        slot->openMidiOutput();
+    }
+
+    // Some platforms require permissions to open input channels so requesting
+    // this here.
+    if (juce::RuntimePermissions::isRequired(
+            juce::RuntimePermissions::recordAudio) &&
+        !juce::RuntimePermissions::isGranted(
+            juce::RuntimePermissions::recordAudio)) {
+        juce::RuntimePermissions::request(
+            juce::RuntimePermissions::recordAudio, [&](bool granted) {
+                setAudioChannels(granted ? numInputChannels_ : 0,
+                                 numOutputChannels);
+            });
+    } else {
+        setAudioChannels(numInputChannels_, numOutputChannels);
+    }
+}
+
+bool anyMidi::AudioProcessor::startCapture(const juce::File &file) {
+    if (deviceOpener_ != nullptr) {
+        anyMidi::log(LogLevel::Error,
+                     "Capture has to start before the audio device opens");
+        return false;
+    }
+    auto &slot = *slots_.front();
+    const auto &config = slot.getConfig();
+    return capture_.start(file, {slot.getPipeline().getAnalysisSampleRate(),
+                                 slot.getPipeline().getFFTBackendName(),
+                                 config.name, config.fftOrder,
+                                 config.settings});
+}
+
+void anyMidi::AudioProcessor::stopCapture() { capture_.stop(); }
+
+bool anyMidi::AudioProcessor::queueParameter(const ParameterChange &change,
+                                             std::size_t slot) {
+    return slot < slots_.size() && parameterQueue_.tryPush({slot, change});
 }
 
 void anyMidi::AudioProcessor::prepareToPlay(int samplesPerBlockExpected,
                                             double sampleRate) {
-    processingBuffer_.setSize(numInputChannels, samplesPerBlockExpected, false,
-                              true);
-    midiProc_.setMidiOutput(deviceManager_->getDefaultMidiOutput());
-
-    // Initializing highpass filter.
-    hiPassFilter_.setCoefficients(
-        juce::IIRCoefficients::makeHighPass(sampleRate, lowFilterFreq));
-    hiPassFilter_.reset();
+    sampleRate_ = sampleRate;
+    blockSize_ = samplesPerBlockExpected;
+    highPass_.reset();
+
+    // Only the first instrument follows the output selected in the device
+    // setup, the others keep their own.
+    for (std::size_t i = 0; i < slots_.size(); ++i) {
+        slots_[i]->prepare(
+            samplesPerBlockExpected, sampleRate,
+            i == 0 ? deviceManager_->getDefaultMidiOutput() : nullptr,
+            pipelineBuilder_);
+    }
+    startTimer(retiredPipelineCheckMs);
+
+    capture_.writePrepare(samplesPerBlockExpected, sampleRate);
+}
+
+void anyMidi::AudioProcessor::waitForPipeline() {
+    while (pipelineBuilder_.getNumJobs() > 0) {
+        juce::Thread::sleep(1);
+    }
+    for (auto &slot : slots_) {
+        slot->freeRetiredPipeline();
+    }
+}
+
+void anyMidi::AudioProcessor::timerCallback() {
+    // Checked first, as the audio thread only retires a pipeline when it
+    // takes a pending one.
+    bool rebuilding = pipelineBuilder_.getNumJobs() > 0;
+    for (const auto &slot : slots_) {
+        rebuilding = rebuilding || slot->isRebuilding();
+    }
+
+    for (auto &slot : slots_) {
+        slot->freeRetiredPipeline();
+    }
+    if (!rebuilding) {
+        stopTimer();
+    }
 }
 
 void anyMidi::AudioProcessor::getNextAudioBlock(
     const juce::AudioSourceChannelInfo &bufferToFill) {
-    if (bufferToFill.buffer->getNumChannels() > 0) {
-        const int numSamples =
-            bufferToFill.buffer->getNumSamples(); // To make sure copied buffer
-                                                  // size is the same.
-
-        // Copies actual buffer into a buffer for processing.
-        for (int i = 0; i < processingBuffer_.getNumChannels(); ++i) {
-            processingBuffer_.copyFrom(
-                i, 0, bufferToFill.buffer->getReadPointer(i), numSamples);
-        }
+    const auto callbackStart = anyMidi::Telemetry::readCycleCounter();
 
-        const auto *channelData =
-            processingBuffer_.getReadPointer(0, bufferToFill.startSample);
-        auto *outBuffer =
-            processingBuffer_.getWritePointer(0, bufferToFill.startSample);
+    if (!firstBlockProcessed_.exchange(true, std::memory_order_relaxed)) {
+        anyMidi::log(LogLevel::Info, "First audio block {:.0f} ms after start",
+                     juce::Time::highResolutionTicksToSeconds(
+                         juce::Time::getHighResolutionTicks() - startTicks_) /
+                         anyMidi::msToSec);
+    }
 
-        // Puts samples into non-const buffer.
-        for (int i = 0; i < numSamples; ++i) {
-            outBuffer[i] = channelData[i];
+    if (!pipelinesHeld_) {
+        for (auto &slot : slots_) {
+            slot->installPendingPipeline();
         }
+    }
 
-        // Applies filter.
-        hiPassFilter_.processSamples(outBuffer, numSamples);
+    // Parameters only change between blocks, so a capture can replay them at
+    // the same place.
+    SlotParameterChange queued;
+    while (parameterQueue_.tryPop(queued)) {
+        slots_[queued.slot]->applyParameter(queued.change);
+        if (queued.slot == 0) {
+            capture_.writeParameter(queued.change);
+        }
+    }
 
-        // Puts samples into FFT fifo after processing.
-        for (int i = 0; i < numSamples; ++i) {
-            fft_.pushNextSampleIntoFifo(outBuffer[i]);
+    const auto &buffer = *bufferToFill.buffer;
+
+    if (buffer.getNumChannels() > 0) {
+        // Raw input of the first instrument, before its pipeline filters it.
+        // Whether it is analysed is recorded too, as a replay has its
+        // rebuilt pipelines ready at once.
+        const int captured = slots_.front()->getInputChannel();
+        if (captured < buffer.getNumChannels()) {
+            capture_.writeBlock(
+                buffer.getReadPointer(captured, bufferToFill.startSample),
+                bufferToFill.numSamples, slots_.front()->isPipelineReady());
         }
     }
 
-    if (fft_.isNextFFTBlockReady()) {
-        calcNote();
-        fft_.setNextFFTBlockReady(false);
+    // Hosts may deliver more than the expected block size, which the slot
+    // buffers are sized for.
+    if (blockSize_ > 0) {
+        for (int start = 0; start < bufferToFill.numSamples;
+             start += blockSize_) {
+            processChunk(buffer, bufferToFill.startSample + start,
+                         std::min(bufferToFill.numSamples - start, blockSize_));
+        }
     }
 
-    midiProc_.pushBufferToOutput();
+    if (sampleRate_ > 0.0) {
+        telemetry_->addCallback(
+            anyMidi::Telemetry::readCycleCounter() - callbackStart,
+            bufferToFill.numSamples / sampleRate_);
+    }
 }
 
-void anyMidi::AudioProcessor::releaseResources() {
-    midiProc_.turnOffAllMessages();
-}
+void anyMidi::AudioProcessor::processChunk(
+    const juce::AudioSampleBuffer &buffer, int startSample, int numSamples) {
+    // Every instrument's input is high-pass filtered in one pass, with the
+    // instruments in vector lanes. An instrument whose channel is not active
+    // on the device gets silence.
+    for (std::size_t i = 0; i < slots_.size(); ++i) {
+        const int channel = slots_[i]->getInputChannel();
+        slotSamples_[i] = slots_[i]->loadInput(
+            channel < buffer.getNumChannels()
+                ? buffer.getReadPointer(channel, startSample)
+                : nullptr,
+            numSamples);
+        highPass_.setCoefficients(static_cast<int>(i),
+                                  slots_[i]->getHighPassCoefficients());
+    }
+    {
+        const ScopedStageTimer timer{telemetry_.get(), Stage::Filter};
+        highPass_.process(slotSamples_.data(),
+                          static_cast<int>(slotSamples_.size()), numSamples);
+    }
 
-void anyMidi::AudioProcessor::calcNote() {
-    auto noteInfo = analyzeHarmonics(); // Gets {note, amplitude}
-    const int note = noteInfo.first;
-    const double amp = noteInfo.second;
-    const int velocity = static_cast<int>(std::round(amp * 127));
-
-    // auto noteInfo = fft.calcFundamentalFreq();
-    // int note = findNearestNote(noteInfo.first);
-
-    std::vector<std::pair<int, bool>> noteValues;
-    if (midiProc_.determineNoteValue(note, amp, noteValues)) {
-        for (const auto &newNote : noteValues) {
-            if (newNote.second) {
-                midiProc_.createMidiMsg(newNote.first,
-                                        static_cast<juce::uint8>(velocity),
-                                        newNote.second);
-            } else {
-                midiProc_.createMidiMsg(newNote.first, 0, newNote.second);
-            }
+    if (midiCollector_ == nullptr) {
+        for (auto &slot : slots_) {
+            slot->analyse(numSamples, nullptr);
         }
+        return;
     }
-}
 
-std::pair<int, double> anyMidi::AudioProcessor::analyzeHarmonics() {
-    auto harmonics = fft_.getHarmonics(numPartials_, noteFrequencies_);
+    chunkEvents_.clear();
+    for (auto &slot : slots_) {
+        slot->analyse(numSamples, &chunkEvents_);
+    }
+    midiCollector_->addEvents(chunkEvents_, 0, -1,
+                              static_cast<int>(collectedSamples_));
+    collectedSamples_ += numSamples;
+}
 
-    std::map<int, double> scores;
-    double totalAmp{0.0};
+void anyMidi::AudioProcessor::releaseResources() {
+    for (auto &slot : slots_) {
+        slot->release();
+    }
+}
 
-    for (int i = 0; i < numPartials_; ++i) {
-        const double freq = noteFrequencies_[harmonics[i].first];
+void anyMidi::AudioProcessor::setAudioChannels(int numInputChannels,
+                                               int numOutputChannels) {
+    deviceOpener_ = std::make_unique<DeviceOpener>(*this, numInputChannels,
+                                                   numOutputChannels);
+    deviceOpener_->startThread();
+}
 
-        // Calculates fundamental frequency of partial based on index.
-        const double fundamental = freq / (i + 1);
+anyMidi::AudioProcessor::DeviceOpener::DeviceOpener(AudioProcessor &processor,
+                                                    int numInputChannels,
+                                                    int numOutputChannels)
+    : juce::Thread{"Audio device opener"}, processor_{processor},
+      numInputChannels_{numInputChannels},
+      numOutputChannels_{numOutputChannels} {}
+
+void anyMidi::AudioProcessor::DeviceOpener::run() {
+    const juce::File deviceSettingsFile =
+        juce::File::getCurrentWorkingDirectory().getChildFile(
+            anyMidi::AUDIO_SETTINGS_FILENAME);
+
+    // Loads settings from file if it exists.
+    std::unique_ptr<juce::XmlElement> storedSettings;
+    if (deviceSettingsFile.existsAsFile()) {
+        storedSettings = juce::parseXML(deviceSettingsFile);
+    }
 
-        // Get nearest MIDI note value of frequency.
-        auto note = anyMidi::findNearestNote(fundamental, noteFrequencies_);
+    // Waits for the message thread to be free, so the window is shown before
+    // the device is opened. Fails if the processor is destroyed meanwhile.
+    const juce::MessageManagerLock lock{this};
+    if (!lock.lockWasGained()) {
+        return;
+    }
 
-        // Scoring weighted based on log2 of freq. FFT bins are distributed
-        // linearly and freqencies are percieved logarithmically. This aims to
-        // let the high frequency bins of the FFT with high resolution have more
-        // weighting on score.
-        scores[note] += 1.0 * log2(fundamental);
+    const juce::String audioError = processor_.deviceManager_->initialise(
+        numInputChannels_, numOutputChannels_, storedSettings.get(), true);
+    processor_.audioDeviceOpened(audioError);
+}
 
-        // Amps of partials added together to represent true amplitude.
-        totalAmp += harmonics[i].second;
+void anyMidi::AudioProcessor::audioDeviceOpened(
+    const juce::String &audioError) {
+    if (audioError.isNotEmpty()) {
+        anyMidi::log(LogLevel::Error, "Failed to open audio device: {}",
+                     audioError.toRawUTF8());
     }
 
-    int correctNote{0};
-    double maxScore{0.0};
+    deviceManager_->addAudioCallback(&audioSourcePlayer_);
+    audioSourcePlayer_.setSource(this);
+    deviceManager_->addChangeListener(this);
 
-    // Finds note with highest score.
-    for (const auto &score : scores) {
-        if (score.second > maxScore) {
-            correctNote = score.first;
-            maxScore = score.second;
-        }
-    }
+    // Adding device manager to ValueTree so AudioDeviceSelectorComponent in GUI
+    // can access it. The audio setup page listens for it to appear.
+    tree_.getChildWithName(anyMidi::AUDIO_PROC_ID)
+        .setProperty(anyMidi::DEVICE_MANAGER_ID, deviceManager_.getObject(),
+                     nullptr);
 
-    auto analyzedNote = std::make_pair(correctNote, totalAmp);
-    return analyzedNote;
+    anyMidi::log(LogLevel::Info, "Audio device opened {:.0f} ms after start",
+                 juce::Time::highResolutionTicksToSeconds(
+                     juce::Time::getHighResolutionTicks() - startTicks_) /
+                     anyMidi::msToSec);
 }
 
-void anyMidi::AudioProcessor::setAudioChannels(
-    int numInputChannels, int numOutputChannels,
-    const juce::XmlElement *const storedSettings) {
-    const juce::String audioError = deviceManager_->initialise(
-        numInputChannels, numOutputChannels, storedSettings, true);
+void anyMidi::AudioProcessor::changeListenerCallback(
+    [[maybe_unused]] juce::ChangeBroadcaster *source) {
+    saveDeviceSettings();
+}
 
-    if (audioError.isEmpty()) {
-        anyMidi::log(tree_, audioError);
+void anyMidi::AudioProcessor::saveDeviceSettings() {
+    const auto audioDeviceSettings = deviceManager_->createStateXml();
+    if (audioDeviceSettings == nullptr) {
+        return;
     }
 
-    deviceManager_->addAudioCallback(&audioSourcePlayer_);
-    audioSourcePlayer_.setSource(this);
+    const juce::File settingsFile =
+        juce::File::getCurrentWorkingDirectory().getChildFile(
+            anyMidi::AUDIO_SETTINGS_FILENAME);
+
+    ++pendingSettingsWrites_;
+    settingsWriter_.addJob(
+        [this, settingsFile, text = audioDeviceSettings->toString()] {
+            // Renaming over the old file is atomic, so a crash mid-write
+            // leaves the previous settings intact.
+            const juce::TemporaryFile temporary{settingsFile};
+            if (!temporary.getFile().replaceWithText(text) ||
+                !temporary.overwriteTargetFileWithTemporary()) {
+                anyMidi::log(LogLevel::Error,
+                             "Failed to write audio device settings");
+            }
+            if (--pendingSettingsWrites_ == 0) {
+                settingsWritten_.signal();
+            }
+        });
 }
 
 void anyMidi::AudioProcessor::valueTreePropertyChanged(
     juce::ValueTree &treeWhosePropertyHasChanged,
     const juce::Identifier &property) {
-    if (property == anyMidi::ATTACK_THRESH_ID) {
-        double t = treeWhosePropertyHasChanged.getProperty(property);
-        midiProc_.setAttackThreshold(t);
-    } else if (property == anyMidi::RELEASE_THRESH_ID) {
-        double t = treeWhosePropertyHasChanged.getProperty(property);
-        midiProc_.setReleaseThreshold(t);
-    } else if (property == anyMidi::PARTIALS_ID) {
-        int n = treeWhosePropertyHasChanged.getProperty(property);
-        setNumPartials(n);
-    } else if (property == anyMidi::LO_CUT_ID) {
-        const double f = treeWhosePropertyHasChanged.getProperty(property);
-        hiPassFilter_.setCoefficients(juce::IIRCoefficients::makeHighPass(
-            deviceManager_.get()->getAudioDeviceSetup().sampleRate, f));
-    } else if (property == anyMidi::CURRENT_WIN_ID) {
-        const int w = treeWhosePropertyHasChanged.getProperty(property);
-        fft_.setWindowingFunction(w);
+    ParameterChange change;
+    while (change.parameter < Parameter::NumParameters &&
+           getParameterId(change.parameter) != property) {
+        change.parameter =
+            static_cast<Parameter>(static_cast<int>(change.parameter) + 1);
+    }
+    if (change.parameter == Parameter::NumParameters) {
+        return;
     }
-}
 
-void anyMidi::AudioProcessor::setNumPartials(int &n) { numPartials_ = n; }
\ No newline at end of file
+    // The GUI edits the first instrument through its node.
+    if (treeWhosePropertyHasChanged.hasType(anyMidi::GUI_ID)) {
+        slots_.front()->getState().setProperty(
+            property, treeWhosePropertyHasChanged.getProperty(property),
+            nullptr);
+        return;
+    }
+
+    for (std::size_t i = 0; i < slots_.size(); ++i) {
+        if (slots_[i]->getState() == treeWhosePropertyHasChanged) {
+            change.value = treeWhosePropertyHasChanged.getProperty(property);
+            if (!queueParameter(change, i)) {
+                anyMidi::log(LogLevel::Warning,
+                             "Parameter queue full, change lost");
+            }
+            return;
+        }
+    }
+}
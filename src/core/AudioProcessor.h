@@ -10,13 +10,21 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <vector>
+
 #include <juce_audio_basics/juce_audio_basics.h>
 #include <juce_audio_devices/juce_audio_devices.h>
 #include <juce_core/juce_core.h>
 #include <juce_data_structures/juce_data_structures.h>
 
-#include "ForwardFFT.h"
-#include "MidiProcessor.h"
+#include "AnalysisPipeline.h"
+#include "BatchHighPass.h"
+#include "Capture.h"
+#include "InstrumentSlot.h"
+#include "SpectrumSnapshot.h"
+#include "Telemetry.h"
 
 namespace anyMidi {
 
@@ -38,20 +46,94 @@ public:
  *
  *  @class   AudioProcessor
  *  @brief   Main audio processing class interacting with the sound card.
+ *           Hosts a session of instruments, each analysing its own input
+ *           channel into its own MIDI output, from one device callback.
  *
  */
 class AudioProcessor : public juce::AudioSource,
-                       public juce::ValueTree::Listener {
+                       public juce::ValueTree::Listener,
+                       private juce::ChangeListener,
+                       private juce::Timer {
 public:
-    explicit AudioProcessor(double sampleRate, const juce::ValueTree &v);
+    /**
+     *  @brief AudioProcessor object constructor.
+     *  @param sampleRate  - Rate to build the pipelines for until the device
+     *                       tells otherwise.
+     *  @param v           - Root of the ValueTree shared with the GUI.
+     *  @param instruments - Instruments of the session. A single instrument
+     *                       on the first input is used if empty. The GUI
+     *                       edits the first.
+     */
+    AudioProcessor(double sampleRate, const juce::ValueTree &v,
+                   const std::vector<InstrumentConfig> &instruments = {});
 
     ~AudioProcessor() override;
 
     /**
-     *  @brief Initializes audio processor. Called upon application start.
+     *  @brief Opens the audio input, asking for permission where required,
+     *         and the instruments' MIDI outputs. Not called when replaying
+     *         a capture. Returns at once, the device is opened from a
+     *         background thread once the message thread is free. Once it is
+     *         open, the device manager is added to the ValueTree and
+     *         processing starts.
+     */
+    void openAudioDevice();
+
+    /**
+     *  @brief  Starts capturing raw input, parameter changes and block sizes
+     *          of the first instrument for replay. Has to be called before
+     *          openAudioDevice(), so the replayed pipeline starts from the
+     *          same fresh state.
+     *  @param  file - Capture file to write.
+     *  @retval      - False if the device is already open or the file could
+     *                 not be opened.
+     */
+    bool startCapture(const juce::File &file);
+
+    void stopCapture();
+
+    /**
+     *  @brief  Queues a parameter change, applied before the next block on
+     *          the audio thread.
+     *  @param  change - Parameter and value.
+     *  @param  slot   - Index of the instrument to change.
+     *  @retval        - False if the queue was full.
+     */
+    bool queueParameter(const ParameterChange &change, std::size_t slot = 0);
+
+    std::size_t getNumInstruments() const { return slots_.size(); }
+
+    /**
+     *  @brief Collects the MIDI events of every block into a buffer,
+     *         positioned by sample since collecting started. Offline use
+     *         only, since collecting allocates.
+     */
+    void setMidiCollector(juce::MidiBuffer *collector) {
+        midiCollector_ = collector;
+        collectedSamples_ = 0;
+    }
+
+    /**
+     *  @brief Initializes audio processor. Called upon application start and
+     *         when the device changes. A new sample rate starts a rebuild of
+     *         the pipelines in the background.
      */
     void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
 
+    /**
+     *  @brief Blocks until a pipeline rebuild started by prepareToPlay() is
+     *         ready to be taken by the next block. Used offline, where no
+     *         block may be skipped while waiting.
+     */
+    void waitForPipeline();
+
+    /**
+     *  @brief Holds rebuilt pipelines back from the next blocks, which then
+     *         go unanalysed, as blocks of a captured stream did while its
+     *         pipeline was being rebuilt. Replay only.
+     */
+    void setPipelinesHeld(bool held) { pipelinesHeld_ = held; }
+
     /**
      *  @brief Handles and processes incoming samples from audio source.
      *  @param bufferToFill - The audio buffer of the application.
@@ -72,57 +154,127 @@ public:
 
 private:
     juce::AudioSourcePlayer audioSourcePlayer_;
-    anyMidi::ForwardFFT fft_;
-    anyMidi::MidiProcessor midiProc_;
+    std::vector<std::unique_ptr<InstrumentSlot>> slots_;
+    /// Filters the input of every instrument together.
+    BatchHighPass highPass_;
+    std::vector<float *> slotSamples_; /// Loaded input, by instrument.
+    int blockSize_{0}; /// Largest number of samples analysed at once.
+    /// Rebuilds the slots' pipelines when the sample rate changes.
+    juce::ThreadPool pipelineBuilder_{1};
+    static constexpr int retiredPipelineCheckMs{50};
+    bool pipelinesHeld_{false};
+
     anyMidi::AudioDeviceManagerRCO::Ptr deviceManager_;
-    juce::AudioSampleBuffer processingBuffer_;
-    juce::IIRFilter hiPassFilter_;
+    anyMidi::Telemetry::Ptr telemetry_{new anyMidi::Telemetry()};
+    anyMidi::SpectrumPublisher::Ptr spectrum_{
+        new anyMidi::SpectrumPublisher()};
+    double sampleRate_{0.0};
 
-    static constexpr double lowFilterFreq{75.0}; // E5 on guitar ~82 Hz
-    static constexpr double highFilterFreq{24000.0};
+    /**
+     *
+     *  @struct  SlotParameterChange
+     *  @brief   Parameter change addressed to an instrument.
+     *
+     */
+    struct SlotParameterChange {
+        std::size_t slot{0};
+        ParameterChange change;
+    };
 
-    static constexpr unsigned int numInputChannels{1};
-    static constexpr unsigned int numOutputChannels{0};
+    /// Parameter changes from the message thread or a replay.
+    static constexpr std::size_t parameterQueueSize{64};
+    MpscQueue<SlotParameterChange, parameterQueueSize> parameterQueue_;
 
-    /// Optimized number of partials for the BSc project
-    static constexpr int defaultNumPartials{6};
+    CaptureWriter capture_;
+    juce::MidiBuffer *midiCollector_{nullptr};
+    /// Events of a chunk, placed by offset into it.
+    juce::MidiBuffer chunkEvents_;
+    juce::int64 collectedSamples_{0};
 
-    int numPartials_{defaultNumPartials};
-    std::vector<double> noteFrequencies_; /// Lookup array to determine Midi
-                                          /// notes from frequencies.
+    /// Enough inputs for the highest channel of any instrument.
+    unsigned int numInputChannels_{1};
+    static constexpr unsigned int numOutputChannels{0};
 
     juce::ValueTree tree_; /// Container for data shared with the GUI.
 
     /**
-     *  @brief Updates number of partials for harmonic analysis.
-     *  @param n - Number of partials to consider during the harmonic analysis.
+     *
+     *  @class   DeviceOpener
+     *  @brief   Reads the stored device settings and opens the audio device
+     *           once the message thread is free. The device manager belongs
+     *           to the message thread, so it is only touched under the
+     *           message manager lock.
+     *
      */
-    void setNumPartials(int &n);
+    class DeviceOpener : public juce::Thread {
+    public:
+        DeviceOpener(AudioProcessor &processor, int numInputChannels,
+                     int numOutputChannels);
+
+        void run() override;
+
+    private:
+        AudioProcessor &processor_;
+        const int numInputChannels_;
+        const int numOutputChannels_;
+    };
+
+    /// Null until the device starts opening.
+    std::unique_ptr<DeviceOpener> deviceOpener_;
+
+    /// Device settings writes not finished yet. The last one to finish
+    /// signals settingsWritten_.
+    std::atomic<int> pendingSettingsWrites_{0};
+    juce::WaitableEvent settingsWritten_;
+    /// How long quitting waits for the settings to be written.
+    static constexpr int settingsWriteTimeoutMs{2000};
+    /// Writes device settings off the message thread.
+    juce::ThreadPool settingsWriter_{1};
+
+    /// Time of construction, for reporting how long startup took.
+    const juce::int64 startTicks_;
+    std::atomic<bool> firstBlockProcessed_{false};
 
     /**
-     *  @brief Creates a MIDI message with note value and amplitude retrieved
-     * from FFT analysis.
+     *  @brief Initializes audio device manager's audio channels on the device
+     *         thread, loading stored settings if there are any.
+     *  @param numInputChannels  - Number of inputs.
+     *  @param numOutputChannels - Number of outputs.
      */
-    void calcNote();
+    void setAudioChannels(int numInputChannels, int numOutputChannels);
 
     /**
-     *  @brief  Determines a signals note value by doing a weighted analysis on
-     *          the harmonical spectrum.
-     *  @retval  - A pair of the estimated note value with its summed signal
-     *             amplitude.
+     *  @brief  Starts processing once the device is open. Message thread, or
+     *          under the message manager lock.
+     *  @param  audioError - Error from opening the device, empty on success.
      */
-    std::pair<int, double> analyzeHarmonics();
+    void audioDeviceOpened(const juce::String &audioError);
 
     /**
-     *  @brief Initializes audio device manager's audio channels.
-     *  @param numInputChannels  - Number of inputs.
-     *  @param numOutputChannels - Number of outputs.
-     *  @param storedSettings    - Optional XML element containing settings to
-     *                             initialize device manager with.
+     *  @brief Filters and analyses part of a block, no longer than the
+     *         prepared block size.
+     *  @param buffer      - Device input.
+     *  @param startSample - First sample of the part.
+     *  @param numSamples  - Number of samples in the part.
+     */
+    void processChunk(const juce::AudioSampleBuffer &buffer, int startSample,
+                      int numSamples);
+
+    /**
+     *  @brief Saves the device settings when they change.
+     */
+    void changeListenerCallback(juce::ChangeBroadcaster *source) override;
+
+    /**
+     *  @brief Writes the device settings to a temporary file which replaces
+     *         the settings file, so it is never left half written.
+     */
+    void saveDeviceSettings();
+
+    /**
+     *  @brief Frees replaced pipelines until no rebuild is in flight.
      */
-    void
-    setAudioChannels(int numInputChannels, int numOutputChannels,
-                     const juce::XmlElement *const storedSettings = nullptr);
+    void timerCallback() override;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioProcessor)
 };
@@ -0,0 +1,114 @@
+/**
+ *
+ *  @file      BatchHighPass.cpp
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#include <algorithm>
+
+#include "BatchHighPass.h"
+
+#include "../util/CpuFeatures.h"
+
+namespace {
+constexpr int laneWidth{anyMidi::BatchHighPass::laneWidth};
+
+/**
+ *  @brief Filters one group of channels. The channels are transposed into
+ *         lanes sample by sample, and the lane loops vectorise to full width.
+ *         Lanes past the number of channels run on silence.
+ */
+forcedinline void filterImpl(float *const *channels, int numChannels,
+                             int numSamples,
+                             anyMidi::BatchHighPass::Lanes &lanes) {
+    alignas(64) std::array<float, laneWidth> x{};
+    alignas(64) std::array<float, laneWidth> y{};
+
+    for (int i = 0; i < numSamples; ++i) {
+        for (int l = 0; l < numChannels; ++l) {
+            x[l] = channels[l][i];
+        }
+
+        for (int l = 0; l < laneWidth; ++l) {
+            y[l] = lanes.b0[l] * x[l] + lanes.z1[l];
+            lanes.z1[l] =
+                lanes.b1[l] * x[l] - lanes.a1[l] * y[l] + lanes.z2[l];
+            lanes.z2[l] = lanes.b2[l] * x[l] - lanes.a2[l] * y[l];
+        }
+
+        for (int l = 0; l < numChannels; ++l) {
+            channels[l][i] = y[l];
+        }
+    }
+}
+
+void filterGeneric(float *const *channels, int numChannels, int numSamples,
+                   anyMidi::BatchHighPass::Lanes &lanes) {
+    filterImpl(channels, numChannels, numSamples, lanes);
+}
+
+#if ANYMIDI_MULTIVERSION
+ANYMIDI_TARGET("avx2,fma")
+void filterAvx2(float *const *channels, int numChannels, int numSamples,
+                anyMidi::BatchHighPass::Lanes &lanes) {
+    filterImpl(channels, numChannels, numSamples, lanes);
+}
+
+ANYMIDI_TARGET("avx512f")
+void filterAvx512(float *const *channels, int numChannels, int numSamples,
+                  anyMidi::BatchHighPass::Lanes &lanes) {
+    filterImpl(channels, numChannels, numSamples, lanes);
+}
+#endif
+} // namespace
+
+anyMidi::BatchHighPass::BatchHighPass() : kernel_{filterGeneric} {
+#if ANYMIDI_MULTIVERSION
+    const auto level = getSimdLevel();
+    if (level == SimdLevel::AVX512) {
+        kernel_ = filterAvx512;
+    } else if (level == SimdLevel::AVX2) {
+        kernel_ = filterAvx2;
+    }
+#endif
+}
+
+void anyMidi::BatchHighPass::prepare(int numChannels) {
+    groups_.assign(
+        static_cast<std::size_t>((numChannels + laneWidth - 1) / laneWidth),
+        Lanes{});
+}
+
+void anyMidi::BatchHighPass::reset() {
+    for (auto &lanes : groups_) {
+        lanes.z1.fill(0.0F);
+        lanes.z2.fill(0.0F);
+    }
+}
+
+void anyMidi::BatchHighPass::setCoefficients(
+    int channel, const juce::IIRCoefficients &coefficients) noexcept {
+    auto &lanes = groups_[static_cast<std::size_t>(channel / laneWidth)];
+    const auto l = static_cast<std::size_t>(channel % laneWidth);
+    const auto *c = coefficients.coefficients;
+
+    lanes.b0[l] = c[0];
+    lanes.b1[l] = c[1];
+    lanes.b2[l] = c[2];
+    lanes.a1[l] = c[3];
+    lanes.a2[l] = c[4];
+}
+
+void anyMidi::BatchHighPass::process(float *const *channels, int numChannels,
+                                     int numSamples) noexcept {
+    const juce::ScopedNoDenormals noDenormals;
+
+    for (int first = 0; first < numChannels; first += laneWidth) {
+        kernel_(channels + first, std::min(laneWidth, numChannels - first),
+                numSamples,
+                groups_[static_cast<std::size_t>(first / laneWidth)]);
+    }
+}
@@ -0,0 +1,96 @@
+/**
+ *
+ *  @file      BatchHighPass.h
+ *  @brief     High-pass filtering of many channels in vector lanes.
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_core/juce_core.h>
+
+namespace anyMidi {
+
+/**
+ *
+ *  @class   BatchHighPass
+ *  @brief   Runs one biquad per channel over a set of channels at once. A
+ *           biquad depends on its previous output, so a single channel
+ *           can't be vectorised, but independent channels can: every
+ *           coefficient and state variable is stored per channel in its own
+ *           array, and each sample step updates a group of channels with one
+ *           vector instruction per term. The kernel is compiled for AVX-512,
+ *           AVX2 and generic CPUs, and the widest supported is chosen at
+ *           construction. Matches juce::IIRFilter, apart from its snapping
+ *           of tiny values to zero, which denormal flushing replaces.
+ *
+ */
+class BatchHighPass {
+public:
+    /// Channels per group, one AVX-512 or two AVX2 registers of floats.
+    static constexpr int laneWidth{16};
+
+    /**
+     *
+     *  @struct  Lanes
+     *  @brief   Coefficients and state of one group of channels.
+     *
+     */
+    struct Lanes {
+        alignas(64) std::array<float, laneWidth> b0{};
+        alignas(64) std::array<float, laneWidth> b1{};
+        alignas(64) std::array<float, laneWidth> b2{};
+        alignas(64) std::array<float, laneWidth> a1{};
+        alignas(64) std::array<float, laneWidth> a2{};
+        alignas(64) std::array<float, laneWidth> z1{};
+        alignas(64) std::array<float, laneWidth> z2{};
+    };
+
+    BatchHighPass();
+
+    /**
+     *  @brief Allocates state for a number of channels and clears it.
+     *         Message thread only.
+     */
+    void prepare(int numChannels);
+
+    /**
+     *  @brief Clears the state of every channel.
+     */
+    void reset();
+
+    /**
+     *  @brief Sets the coefficients of a channel. Real-time safe.
+     *  @param channel      - Index of the channel.
+     *  @param coefficients - Normalised coefficients, as used by
+     *                        juce::IIRFilter.
+     */
+    void setCoefficients(int channel,
+                         const juce::IIRCoefficients &coefficients) noexcept;
+
+    /**
+     *  @brief Filters the channels in place. Real-time safe.
+     *  @param channels    - One pointer per prepared channel.
+     *  @param numChannels - Number of channels, at most as many as prepared.
+     *  @param numSamples  - Samples per channel.
+     */
+    void process(float *const *channels, int numChannels,
+                 int numSamples) noexcept;
+
+private:
+    using Kernel = void (*)(float *const *, int, int, Lanes &);
+
+    std::vector<Lanes> groups_;
+    Kernel kernel_;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BatchHighPass)
+};
+
+} // namespace anyMidi
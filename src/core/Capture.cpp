@@ -0,0 +1,363 @@
+/**
+ *
+ *  @file      Capture.cpp
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#include <algorithm>
+#include <iostream>
+
+#include "AudioProcessor.h"
+#include "Capture.h"
+#include "FFTBackend.h"
+
+#include "../util/Globals.h"
+#include "../util/Logger.h"
+
+anyMidi::CaptureWriter::CaptureWriter() : juce::Thread{"Capture writer"} {}
+
+anyMidi::CaptureWriter::~CaptureWriter() { stop(); }
+
+bool anyMidi::CaptureWriter::start(const juce::File &file,
+                                   const CaptureHeader &header) {
+    stop();
+
+    file.deleteFile();
+    stream_ = std::make_unique<juce::FileOutputStream>(file);
+    if (stream_->failedToOpen()) {
+        stream_ = nullptr;
+        anyMidi::log(LogLevel::Error, "Failed to open capture file {}",
+                     file.getFullPathName().toRawUTF8());
+        return false;
+    }
+
+    stream_->writeInt(static_cast<int>(magic));
+    stream_->writeInt(version);
+    stream_->writeDouble(header.sampleRate);
+    stream_->writeString(header.fftBackend);
+    stream_->writeString(header.instrumentName);
+    stream_->writeInt(header.fftOrder);
+    stream_->writeInt(static_cast<int>(header.settings.size()));
+    for (const auto &setting : header.settings) {
+        stream_->writeByte(static_cast<char>(setting.parameter));
+        stream_->writeDouble(setting.value);
+    }
+
+    file_ = file;
+    overflowed_.store(false, std::memory_order_relaxed);
+    startThread();
+    capturing_.store(true, std::memory_order_release);
+
+    anyMidi::log(LogLevel::Info, "Capturing input to {}",
+                 file.getFullPathName().toRawUTF8());
+    return true;
+}
+
+void anyMidi::CaptureWriter::stop() {
+    capturing_.store(false);
+    while (writing_.load()) {
+        juce::Thread::yield();
+    }
+
+    if (stream_ == nullptr) {
+        return;
+    }
+
+    // The thread drains what is left before it exits.
+    stopThread(-1);
+    stream_ = nullptr;
+
+    if (overflowed_.load(std::memory_order_acquire)) {
+        anyMidi::log(LogLevel::Warning,
+                     "Capture ring overflowed, {} is cut short",
+                     file_.getFullPathName().toRawUTF8());
+    }
+}
+
+template <typename Fill>
+void anyMidi::CaptureWriter::push(Fill &&fill) noexcept {
+    if (!queue_.tryPushWith(std::forward<Fill>(fill))) {
+        // Writing on after a lost page would misalign the stream.
+        overflowed_.store(true, std::memory_order_release);
+        capturing_.store(false, std::memory_order_release);
+    }
+}
+
+namespace {
+/**
+ *  @brief Runs body only while capturing, telling stop() to wait for it.
+ *         Announcing before checking means stop() either sees the write in
+ *         progress or the write sees the capture stopped.
+ */
+template <typename Body>
+void guardedWrite(const std::atomic<bool> &capturing,
+                  std::atomic<bool> &writing, Body &&body) {
+    if (!capturing.load(std::memory_order_acquire)) {
+        return;
+    }
+    writing.store(true);
+    if (capturing.load()) {
+        body();
+    }
+    writing.store(false, std::memory_order_release);
+}
+} // namespace
+
+void anyMidi::CaptureWriter::writePrepare(int blockSize,
+                                          double sampleRate) noexcept {
+    guardedWrite(capturing_, writing_, [&] {
+        push([&](CapturePage &page) {
+            page.type = CaptureRecord::Prepare;
+            page.count = blockSize;
+            page.change.value = sampleRate;
+        });
+    });
+}
+
+void anyMidi::CaptureWriter::writeParameter(
+    const ParameterChange &change) noexcept {
+    guardedWrite(capturing_, writing_, [&] {
+        push([&](CapturePage &page) {
+            page.type = CaptureRecord::Parameter;
+            page.change = change;
+        });
+    });
+}
+
+void anyMidi::CaptureWriter::writeBlock(const float *samples, int numSamples,
+                                        bool analysed) noexcept {
+    guardedWrite(capturing_, writing_, [&] {
+        int start{0};
+        // Empty blocks are recorded as well, as they still advance the
+        // processor.
+        do {
+            const int count =
+                std::min(numSamples - start, CapturePage::maxSamples);
+            push([&](CapturePage &page) {
+                page.type = CaptureRecord::Samples;
+                page.count = count;
+                page.endOfBlock = start + count >= numSamples;
+                page.analysed = analysed;
+                std::copy_n(samples + start, count, page.samples.begin());
+            });
+            start += count;
+        } while (start < numSamples && isCapturing());
+    });
+}
+
+void anyMidi::CaptureWriter::run() {
+    while (!threadShouldExit()) {
+        drain();
+        wait(drainIntervalMs);
+    }
+    drain();
+}
+
+void anyMidi::CaptureWriter::drain() {
+    CapturePage page;
+    bool wrote{false};
+
+    while (queue_.tryPop(page)) {
+        wrote = true;
+        stream_->writeByte(static_cast<char>(page.type));
+
+        switch (page.type) {
+        case CaptureRecord::Prepare:
+            stream_->writeInt(page.count);
+            stream_->writeDouble(page.change.value);
+            break;
+        case CaptureRecord::Parameter:
+            stream_->writeByte(static_cast<char>(page.change.parameter));
+            stream_->writeDouble(page.change.value);
+            break;
+        case CaptureRecord::Samples:
+            stream_->writeInt(page.count);
+            for (int i = 0; i < page.count; ++i) {
+                stream_->writeFloat(page.samples[i]);
+            }
+            if (page.endOfBlock) {
+                stream_->writeByte(static_cast<char>(CaptureRecord::BlockEnd));
+                stream_->writeByte(page.analysed ? 1 : 0);
+            }
+            break;
+        case CaptureRecord::BlockEnd:
+            break;
+        }
+    }
+
+    if (wrote) {
+        stream_->flush();
+    }
+}
+
+anyMidi::CaptureReader::CaptureReader(const juce::File &file)
+    : stream_{std::make_unique<juce::FileInputStream>(file)} {
+    if (stream_->failedToOpen()) {
+        return;
+    }
+
+    const auto fileMagic = static_cast<std::uint32_t>(stream_->readInt());
+    const int fileVersion = stream_->readInt();
+
+    valid_ = fileMagic == CaptureWriter::magic &&
+             fileVersion == CaptureWriter::version && readHeader();
+}
+
+bool anyMidi::CaptureReader::readHeader() {
+    header_.sampleRate = stream_->readDouble();
+    header_.fftBackend = stream_->readString();
+    header_.instrumentName = stream_->readString();
+    header_.fftOrder = stream_->readInt();
+    if (header_.sampleRate <= 0.0 || header_.fftOrder < ForwardFFT::minOrder ||
+        header_.fftOrder > ForwardFFT::maxOrder) {
+        return false;
+    }
+
+    const int numSettings = stream_->readInt();
+    if (numSettings < 0 ||
+        numSettings > static_cast<int>(Parameter::NumParameters)) {
+        return false;
+    }
+    for (int i = 0; i < numSettings; ++i) {
+        const auto parameter = static_cast<std::uint8_t>(stream_->readByte());
+        if (parameter >= static_cast<std::uint8_t>(Parameter::NumParameters)) {
+            return false;
+        }
+        header_.settings.push_back(
+            {static_cast<Parameter>(parameter), stream_->readDouble()});
+    }
+    return !stream_->isExhausted();
+}
+
+bool anyMidi::CaptureReader::readNext(CaptureEvent &event) {
+    if (!valid_) {
+        return false;
+    }
+
+    event.samples.clear();
+
+    while (!stream_->isExhausted()) {
+        const auto type = static_cast<CaptureRecord>(stream_->readByte());
+
+        switch (type) {
+        case CaptureRecord::Prepare:
+            event.type = CaptureEvent::Type::Prepare;
+            event.blockSize = stream_->readInt();
+            event.sampleRate = stream_->readDouble();
+            return event.sampleRate > 0.0;
+        case CaptureRecord::Parameter: {
+            const auto parameter =
+                static_cast<std::uint8_t>(stream_->readByte());
+            if (parameter >=
+                static_cast<std::uint8_t>(Parameter::NumParameters)) {
+                return false;
+            }
+            event.type = CaptureEvent::Type::Parameter;
+            event.change = {static_cast<Parameter>(parameter),
+                            stream_->readDouble()};
+            return true;
+        }
+        case CaptureRecord::Samples: {
+            const int count = stream_->readInt();
+            const auto remaining =
+                stream_->getTotalLength() - stream_->getPosition();
+            if (count < 0 ||
+                static_cast<juce::int64>(count * sizeof(float)) > remaining) {
+                return false; // Cut off by the end of the file.
+            }
+            for (int i = 0; i < count; ++i) {
+                event.samples.push_back(stream_->readFloat());
+            }
+            break;
+        }
+        case CaptureRecord::BlockEnd:
+            event.type = CaptureEvent::Type::Block;
+            event.analysed = stream_->readByte() != 0;
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    return false;
+}
+
+bool anyMidi::runReplay(const juce::File &file) {
+    CaptureReader reader{file};
+    if (!reader.isValid()) {
+        std::cout << "Not a capture file: " << file.getFullPathName() << "\n";
+        return false;
+    }
+    const auto &header = reader.getHeader();
+
+    // The backend is chosen by timing, so the fastest now may not be the one
+    // captured.
+    if (!pinFFTBackend(header.fftBackend)) {
+        std::cout << "Unknown FFT backend in capture: " << header.fftBackend
+                  << "\n";
+        return false;
+    }
+
+    juce::ValueTree tree{anyMidi::ROOT_ID};
+    tree.addChild(juce::ValueTree{anyMidi::AUDIO_PROC_ID}, -1, nullptr);
+    tree.addChild(juce::ValueTree{anyMidi::GUI_ID}, -1, nullptr);
+
+    // Only the captured input is replayed, so it becomes the first.
+    InstrumentConfig instrument;
+    instrument.name = header.instrumentName;
+    instrument.fftOrder = header.fftOrder;
+    instrument.settings = header.settings;
+
+    // No audio device is opened, blocks are fed by hand instead.
+    auto processor = std::make_unique<AudioProcessor>(
+        header.sampleRate, tree, std::vector<InstrumentConfig>{instrument});
+    juce::MidiBuffer midi;
+    processor->setMidiCollector(&midi);
+
+    juce::AudioSampleBuffer buffer;
+    CaptureEvent event;
+    int numBlocks{0};
+
+    while (reader.readNext(event)) {
+        switch (event.type) {
+        case CaptureEvent::Type::Prepare:
+            processor->prepareToPlay(event.blockSize, event.sampleRate);
+            processor->waitForPipeline();
+            break;
+        case CaptureEvent::Type::Parameter:
+            processor->queueParameter(event.change);
+            break;
+        case CaptureEvent::Type::Block: {
+            const auto numSamples = static_cast<int>(event.samples.size());
+            buffer.setSize(1, numSamples, false, false, true);
+            buffer.copyFrom(0, 0, event.samples.data(), numSamples);
+            // The rebuilt pipeline takes over at the same block as it did
+            // live.
+            processor->setPipelinesHeld(!event.analysed);
+            processor->getNextAudioBlock(
+                juce::AudioSourceChannelInfo{&buffer, 0, numSamples});
+            ++numBlocks;
+            break;
+        }
+        }
+    }
+
+    for (const auto metadata : midi) {
+        std::cout << metadata.samplePosition << " "
+                  << metadata.getMessage().getDescription() << "\n";
+    }
+    std::cout << numBlocks << " blocks, " << midi.getNumEvents()
+              << " MIDI events\n\n";
+
+    auto *telemetry = dynamic_cast<Telemetry *>(
+        tree.getChildWithName(anyMidi::AUDIO_PROC_ID)
+            .getProperty(anyMidi::TELEMETRY_ID)
+            .getObject());
+    if (telemetry != nullptr) {
+        std::cout << telemetry->getSnapshot().toCsv();
+    }
+    return true;
+}
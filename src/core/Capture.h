@@ -0,0 +1,261 @@
+/**
+ *
+ *  @file      Capture.h
+ *  @brief     Recording of raw input for deterministic offline replay.
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include <juce_core/juce_core.h>
+
+#include "../util/MpscQueue.h"
+
+namespace anyMidi {
+
+/**
+ *  @brief Settings that change the pipeline's output. Changes are applied at
+ *         block boundaries on the audio thread, so they can be captured and
+ *         replayed at the same place in the stream.
+ */
+enum class Parameter : std::uint8_t {
+    AttackThreshold,
+    ReleaseThreshold,
+    NumPartials,
+    LowCutFrequency,
+    Mpe,
+    WindowingFunction,
+    AdaptiveWindow,
+    SmoothingLag,
+    IncrementalAnalysis,
+    SlidingTracking,
+    NumParameters
+};
+
+/**
+ *
+ *  @struct  ParameterChange
+ *  @brief   New value of a parameter.
+ *
+ */
+struct ParameterChange {
+    Parameter parameter{Parameter::AttackThreshold};
+    double value{0.0};
+};
+
+/**
+ *
+ *  @struct  CaptureHeader
+ *  @brief   What a replay needs to rebuild the captured instrument.
+ *
+ */
+struct CaptureHeader {
+    double sampleRate{0.0}; /// Rate the pipeline was constructed with.
+    juce::String fftBackend;
+    juce::String instrumentName;
+    int fftOrder{0};
+    /// Settings the instrument was configured with, before any change.
+    std::vector<ParameterChange> settings;
+};
+
+/**
+ *  @brief Kinds of records in a capture file. The file starts with the magic
+ *         number and the format version, followed by the header:
+ *         double sample rate, string FFT backend, string instrument name,
+ *         int FFT order, int number of settings and a byte parameter and
+ *         double value for each. Then records follow:
+ *         - Prepare:   int block size, double sample rate.
+ *         - Parameter: byte parameter, double value.
+ *         - Samples:   int count, count floats.
+ *         - BlockEnd:  byte, 1 if the block was analysed, 0 if it was let
+ *                      through while a rebuilt pipeline was on its way. Ends
+ *                      the block of the preceding samples.
+ *         All values are little endian.
+ */
+enum class CaptureRecord : std::uint8_t {
+    Prepare,
+    Parameter,
+    Samples,
+    BlockEnd
+};
+
+/**
+ *
+ *  @struct  CapturePage
+ *  @brief   Preallocated unit passed from the audio thread to the writer.
+ *           Blocks larger than a page are split over several.
+ *
+ */
+struct CapturePage {
+    static constexpr int maxSamples{512};
+
+    CaptureRecord type{CaptureRecord::Samples};
+    bool endOfBlock{false}; /// Last samples page of a block.
+    bool analysed{true};    /// Whether the block of the page was analysed.
+    int count{0};           /// Samples in page, or block size of Prepare.
+    ParameterChange change; /// Parameter, or sample rate of Prepare as value.
+    std::array<float, maxSamples> samples{};
+};
+
+/**
+ *
+ *  @class   CaptureWriter
+ *  @brief   Streams input blocks, parameter changes and prepare calls to a
+ *           capture file. The audio thread only fills pages of a lock-free
+ *           ring, a background thread drains them to disk. If the ring
+ *           overflows the capture is ended there, so the file always holds
+ *           an unbroken prefix of the stream.
+ *
+ */
+class CaptureWriter : private juce::Thread {
+public:
+    static constexpr std::uint32_t magic{0x50434d41}; // "AMCP"
+    static constexpr int version{1};
+
+    CaptureWriter();
+    ~CaptureWriter() override;
+
+    /**
+     *  @brief  Opens the file, writes the header and starts the writer thread.
+     *          Message thread only.
+     *  @param  file   - File to write, replaced if it exists.
+     *  @param  header - The captured instrument.
+     *  @retval        - False if the file could not be opened.
+     */
+    bool start(const juce::File &file, const CaptureHeader &header);
+
+    /**
+     *  @brief Stops capturing, writes what is left in the ring and closes the
+     *         file. Message thread only.
+     */
+    void stop();
+
+    bool isCapturing() const {
+        return capturing_.load(std::memory_order_acquire);
+    }
+
+    /**
+     *  @brief Records a call to prepareToPlay(). Real-time safe.
+     */
+    void writePrepare(int blockSize, double sampleRate) noexcept;
+
+    /**
+     *  @brief Records a parameter change applied before the next block.
+     *         Real-time safe.
+     */
+    void writeParameter(const ParameterChange &change) noexcept;
+
+    /**
+     *  @brief Records a block of raw input samples. Real-time safe.
+     *  @param samples    - Raw input.
+     *  @param numSamples - Number of samples.
+     *  @param analysed   - False if the block goes unanalysed, waiting for a
+     *                      rebuilt pipeline.
+     */
+    void writeBlock(const float *samples, int numSamples,
+                    bool analysed) noexcept;
+
+private:
+    static constexpr std::size_t ringCapacity{1024};
+    static constexpr int drainIntervalMs{20};
+
+    void run() override;
+
+    /**
+     *  @brief Pushes a page, ending the capture if the ring is full.
+     */
+    template <typename Fill> void push(Fill &&fill) noexcept;
+
+    /**
+     *  @brief Writes every queued page to the file.
+     */
+    void drain();
+
+    MpscQueue<CapturePage, ringCapacity> queue_;
+    std::unique_ptr<juce::FileOutputStream> stream_;
+    juce::File file_;
+
+    std::atomic<bool> capturing_{false};
+    /// Set by the audio thread while it fills pages, so stop() can wait for
+    /// the last page of a block before draining.
+    std::atomic<bool> writing_{false};
+    std::atomic<bool> overflowed_{false};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CaptureWriter)
+};
+
+/**
+ *
+ *  @struct  CaptureEvent
+ *  @brief   One event read back from a capture file.
+ *
+ */
+struct CaptureEvent {
+    enum class Type : std::uint8_t { Prepare, Parameter, Block };
+
+    Type type{Type::Block};
+    int blockSize{0};
+    double sampleRate{0.0};
+    ParameterChange change;
+    std::vector<float> samples;
+    bool analysed{true};
+};
+
+/**
+ *
+ *  @class   CaptureReader
+ *  @brief   Reads the events of a capture file in order. A block cut off by
+ *           the end of the file is discarded.
+ *
+ */
+class CaptureReader {
+public:
+    explicit CaptureReader(const juce::File &file);
+
+    /**
+     *  @brief  Whether the file exists and has a valid header.
+     */
+    bool isValid() const { return valid_; }
+
+    const CaptureHeader &getHeader() const { return header_; }
+
+    /**
+     *  @brief  Reads the next event.
+     *  @param  event - Destination, its sample vector is reused.
+     *  @retval       - False at the end of the file.
+     */
+    bool readNext(CaptureEvent &event);
+
+private:
+    std::unique_ptr<juce::FileInputStream> stream_;
+    bool valid_{false};
+    CaptureHeader header_;
+
+    /**
+     *  @brief  Reads the header after the format version.
+     *  @retval - False if it is cut off or out of range.
+     */
+    bool readHeader();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CaptureReader)
+};
+
+/**
+ *  @brief  Feeds a capture file through a device-less AudioProcessor with the
+ *          captured instrument, block sizes, parameter changes and FFT
+ *          backend, printing the MIDI events and stage timings to standard
+ *          output.
+ *  @param  file - Capture file to replay.
+ *  @retval      - False if the file could not be read.
+ */
+bool runReplay(const juce::File &file);
+
+} // namespace anyMidi
@@ -0,0 +1,347 @@
+/**
+ *
+ *  @file      Evaluation.cpp
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iostream>
+
+#include "AnalysisPipeline.h"
+#include "Evaluation.h"
+#include "FFTBackend.h"
+
+namespace {
+constexpr double msPerSecond{1000.0};
+
+double percentile(std::vector<double> values, double fraction) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    const auto index = static_cast<std::size_t>(
+        std::round(fraction * static_cast<double>(values.size() - 1)));
+    return values[index];
+}
+
+/**
+ *  @brief  Note on events of a MIDI buffer as {note, seconds} pairs.
+ */
+std::vector<std::pair<int, double>> getNoteOns(const juce::MidiBuffer &buffer,
+                                               double sampleRate) {
+    std::vector<std::pair<int, double>> noteOns;
+    for (const auto metadata : buffer) {
+        const auto message = metadata.getMessage();
+        if (message.isNoteOn()) {
+            noteOns.emplace_back(message.getNoteNumber(),
+                                 metadata.samplePosition / sampleRate);
+        }
+    }
+    return noteOns;
+}
+} // namespace
+
+juce::var anyMidi::EvaluationResult::toVar() const {
+    auto object = std::make_unique<juce::DynamicObject>();
+    object->setProperty("truth", numTruth);
+    object->setProperty("detected", numDetected);
+    object->setProperty("matched", numMatched);
+    object->setProperty("precision", precision);
+    object->setProperty("recall", recall);
+    object->setProperty("f1", f1);
+    object->setProperty("medianLatencyMs", medianLatencyMs);
+    object->setProperty("p90LatencyMs", p90LatencyMs);
+    object->setProperty("maxLatencyMs", maxLatencyMs);
+    return object.release();
+}
+
+anyMidi::Evaluator::Evaluator(double sampleRate, int blockSize)
+    : sampleRate_{sampleRate}, blockSize_{blockSize} {}
+
+std::vector<anyMidi::EvaluationCase>
+anyMidi::Evaluator::createDefaultCases() {
+    std::vector<EvaluationCase> cases;
+
+    // Open strings, one at a time.
+    {
+        EvaluationCase singleNotes{"single_notes", {}};
+        constexpr std::array<int, 6> openStrings{40, 45, 50, 55, 59, 64};
+        constexpr double spacing{0.8};
+        constexpr double duration{0.7};
+        double onset{0.2};
+        for (const int note : openStrings) {
+            singleNotes.notes.push_back({note, onset, duration});
+            onset += spacing;
+        }
+        cases.push_back(singleNotes);
+    }
+
+    // Strummed E major and A major chords.
+    {
+        EvaluationCase chords{"chords", {}};
+        constexpr std::array<std::array<int, 6>, 2> shapes{
+            {{40, 47, 52, 56, 59, 64}, {45, 52, 57, 61, 64, 69}}};
+        constexpr double strumSpread{0.015};
+        constexpr double spacing{1.5};
+        constexpr double duration{1.3};
+        double onset{0.2};
+        for (const auto &shape : shapes) {
+            for (std::size_t i = 0; i < shape.size(); ++i) {
+                chords.notes.push_back(
+                    {shape[i], onset + static_cast<double>(i) * strumSpread,
+                     duration});
+            }
+            onset += spacing;
+        }
+        cases.push_back(chords);
+    }
+
+    // Whole and half step bends, which should not retrigger.
+    {
+        EvaluationCase bends{"bends", {}};
+        constexpr double bendTime{0.2};
+        bends.notes.push_back({57, 0.2, 1.2, 2.0, bendTime});
+        bends.notes.push_back({62, 1.6, 1.2, 1.0, bendTime});
+        bends.notes.push_back({52, 3.0, 1.2, 2.0, bendTime});
+        cases.push_back(bends);
+    }
+
+    // C major scale as sixteenths at 140 bpm, up and down.
+    {
+        EvaluationCase fastRun{"fast_run", {}};
+        constexpr std::array<int, 15> scale{48, 50, 52, 53, 55, 57, 59, 60,
+                                            59, 57, 55, 53, 52, 50, 48};
+        constexpr double sixteenth{60.0 / 140.0 / 4.0};
+        double onset{0.2};
+        for (const int note : scale) {
+            fastRun.notes.push_back({note, onset, sixteenth});
+            onset += sixteenth;
+        }
+        cases.push_back(fastRun);
+    }
+
+    return cases;
+}
+
+std::vector<float>
+anyMidi::Evaluator::render(const EvaluationCase &evalCase) const {
+    constexpr double tail{0.5};
+    double length{0.0};
+    for (const auto &n : evalCase.notes) {
+        length = std::max(length, n.onset + n.duration + tail);
+    }
+
+    std::vector<float> signal(static_cast<std::size_t>(length * sampleRate_));
+
+    constexpr int numHarmonics{10};
+    constexpr double baseDecay{1.5};   // Per second, fundamental.
+    constexpr double decaySlope{0.5};  // Extra decay per harmonic number.
+    constexpr double noiseTime{0.005}; // Pick attack.
+    constexpr double damping{0.02};    // Fade out when the note is released.
+    constexpr double noiseGain{0.3};
+    constexpr double a4{440.0};
+    constexpr int a4Note{69};
+    constexpr double octave{12.0};
+
+    // Fixed seed, so signals are identical between runs.
+    juce::Random random{1};
+
+    for (const auto &n : evalCase.notes) {
+        const auto first = static_cast<std::size_t>(n.onset * sampleRate_);
+        const auto last = std::min(
+            signal.size(), static_cast<std::size_t>(
+                               (n.onset + n.duration + damping) * sampleRate_));
+
+        std::array<double, numHarmonics> phases{};
+        for (std::size_t i = first; i < last; ++i) {
+            const double t = static_cast<double>(i - first) / sampleRate_;
+
+            double semitones = n.note - a4Note;
+            if (n.bendTime > 0.0) {
+                semitones += n.bend * std::min(t / n.bendTime, 1.0);
+            }
+            const double f0 = a4 * std::pow(2.0, semitones / octave);
+
+            double sample{0.0};
+            for (int h = 1; h <= numHarmonics; ++h) {
+                const double f = f0 * h;
+                if (f >= sampleRate_ / 2) {
+                    break;
+                }
+                auto &phase = phases[static_cast<std::size_t>(h - 1)];
+                phase += juce::MathConstants<double>::twoPi * f / sampleRate_;
+                const double decay = baseDecay * (1.0 + decaySlope * h);
+                sample += std::sin(phase) * std::exp(-decay * t) / h;
+            }
+
+            if (t < noiseTime) {
+                sample += noiseGain * (random.nextDouble() * 2.0 - 1.0) *
+                          (1.0 - t / noiseTime);
+            }
+            if (t > n.duration) {
+                sample *= 1.0 - (t - n.duration) / damping;
+            }
+
+            signal[i] += static_cast<float>(n.velocity * sample);
+        }
+    }
+
+    return signal;
+}
+
+anyMidi::EvaluationResult
+anyMidi::Evaluator::run(const EvaluationCase &evalCase) const {
+    auto signal = render(evalCase);
+
+    AnalysisPipeline pipeline{sampleRate_};
+    juce::MidiBuffer block;
+    juce::MidiBuffer output;
+
+    // Events come placed by offset into their block.
+    const auto total = static_cast<int>(signal.size());
+    for (int start = 0; start < total; start += blockSize_) {
+        const int numSamples = std::min(blockSize_, total - start);
+        block.clear();
+        pipeline.processBlock(signal.data() + start, numSamples, &block);
+        output.addEvents(block, 0, -1, start);
+    }
+
+    const auto detected = getNoteOns(output, sampleRate_);
+
+    // Greedy matching in time order, every true note matching at most one
+    // detected note of the same value.
+    std::vector<bool> used(detected.size(), false);
+    std::vector<double> latencies;
+    for (const auto &truth : evalCase.notes) {
+        for (std::size_t i = 0; i < detected.size(); ++i) {
+            const double offset = detected[i].second - truth.onset;
+            if (!used[i] && detected[i].first == truth.note &&
+                offset >= -earlyTolerance && offset <= lateTolerance) {
+                used[i] = true;
+                latencies.push_back(offset * msPerSecond);
+                break;
+            }
+        }
+    }
+
+    EvaluationResult result;
+    result.name = evalCase.name;
+    result.numTruth = static_cast<int>(evalCase.notes.size());
+    result.numDetected = static_cast<int>(detected.size());
+    result.numMatched = static_cast<int>(latencies.size());
+
+    if (result.numDetected > 0) {
+        result.precision = static_cast<double>(result.numMatched) /
+                           static_cast<double>(result.numDetected);
+    }
+    if (result.numTruth > 0) {
+        result.recall = static_cast<double>(result.numMatched) /
+                        static_cast<double>(result.numTruth);
+    }
+    if (result.precision + result.recall > 0.0) {
+        result.f1 = 2.0 * result.precision * result.recall /
+                    (result.precision + result.recall);
+    }
+
+    constexpr double median{0.5};
+    constexpr double p90{0.9};
+    result.medianLatencyMs = percentile(latencies, median);
+    result.p90LatencyMs = percentile(latencies, p90);
+    result.maxLatencyMs = percentile(latencies, 1.0);
+
+    return result;
+}
+
+bool anyMidi::Evaluator::compareToBaseline(
+    const std::vector<EvaluationResult> &results, const juce::var &baseline,
+    juce::StringArray &failures) {
+    for (const auto &result : results) {
+        const auto expected = baseline[juce::Identifier{result.name}];
+        if (expected.isVoid()) {
+            failures.add(result.name + ": missing from baseline");
+            continue;
+        }
+
+        const double expectedF1 = expected["f1"];
+        if (result.f1 < expectedF1 - f1Tolerance) {
+            failures.add(result.name + ": F1 " + juce::String(result.f1, 3) +
+                         " below baseline " + juce::String(expectedF1, 3));
+        }
+
+        const double expectedLatency = expected["medianLatencyMs"];
+        if (result.medianLatencyMs > expectedLatency + latencyToleranceMs) {
+            failures.add(result.name + ": median latency " +
+                         juce::String(result.medianLatencyMs, 1) +
+                         " ms above baseline " +
+                         juce::String(expectedLatency, 1) + " ms");
+        }
+    }
+    return failures.isEmpty();
+}
+
+juce::String
+anyMidi::Evaluator::toJson(const std::vector<EvaluationResult> &results) {
+    auto root = std::make_unique<juce::DynamicObject>();
+    for (const auto &result : results) {
+        root->setProperty(juce::Identifier{result.name}, result.toVar());
+    }
+    return juce::JSON::toString(juce::var(root.release()));
+}
+
+bool anyMidi::runEvaluation(const juce::File &baselineFile,
+                            bool updateBaseline) {
+    constexpr double sampleRate{48000.0};
+    constexpr int blockSize{256};
+    const Evaluator evaluator{sampleRate, blockSize};
+
+    // The fastest backend is found by timing, so it can change between runs
+    // and machines, and with it the rounding the baseline was made with.
+    pinFFTBackend("JUCE");
+
+    std::vector<EvaluationResult> results;
+    for (const auto &evalCase : Evaluator::createDefaultCases()) {
+        results.push_back(evaluator.run(evalCase));
+        const auto &r = results.back();
+        std::cout << r.name << ": precision " << r.precision << ", recall "
+                  << r.recall << ", F1 " << r.f1 << ", latency median "
+                  << r.medianLatencyMs << " ms, p90 " << r.p90LatencyMs
+                  << " ms, max " << r.maxLatencyMs << " ms\n";
+    }
+
+    if (updateBaseline) {
+        if (!baselineFile.replaceWithText(Evaluator::toJson(results))) {
+            std::cout << "Failed to write baseline "
+                      << baselineFile.getFullPathName() << "\n";
+            return false;
+        }
+        std::cout << "Baseline written to " << baselineFile.getFullPathName()
+                  << "\n";
+        return true;
+    }
+
+    // Writing a missing baseline here would let a regression pass as the
+    // new baseline.
+    if (!baselineFile.existsAsFile()) {
+        std::cout << "No baseline at " << baselineFile.getFullPathName()
+                  << ", run with --update-baseline to create it\n";
+        return false;
+    }
+
+    juce::StringArray failures;
+    if (!Evaluator::compareToBaseline(
+            results, juce::JSON::parse(baselineFile), failures)) {
+        for (const auto &failure : failures) {
+            std::cout << "REGRESSION " << failure << "\n";
+        }
+        return false;
+    }
+
+    std::cout << "No regressions against " << baselineFile.getFullPathName()
+              << "\n";
+    return true;
+}
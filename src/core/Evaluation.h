@@ -0,0 +1,136 @@
+/**
+ *
+ *  @file      Evaluation.h
+ *  @brief     Offline accuracy and latency evaluation of the pipeline.
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <juce_core/juce_core.h>
+
+namespace anyMidi {
+
+/**
+ *
+ *  @struct  GroundTruthNote
+ *  @brief   A note rendered into an evaluation signal.
+ *
+ */
+struct GroundTruthNote {
+    int note{0};          /// MIDI note value of the played pitch, as sent.
+    double onset{0.0};    /// Seconds from start of signal.
+    double duration{0.0}; /// Seconds until the string is damped.
+    double bend{0.0};     /// Semitones bent up over bendTime after onset.
+    double bendTime{0.0};
+    float velocity{0.5F};
+};
+
+/**
+ *
+ *  @struct  EvaluationCase
+ *  @brief   Named signal with known notes.
+ *
+ */
+struct EvaluationCase {
+    juce::String name;
+    std::vector<GroundTruthNote> notes;
+};
+
+/**
+ *
+ *  @struct  EvaluationResult
+ *  @brief   Scores of one evaluation case.
+ *
+ */
+struct EvaluationResult {
+    juce::String name;
+    int numTruth{0};
+    int numDetected{0};
+    int numMatched{0};
+
+    double precision{0.0};
+    double recall{0.0};
+    double f1{0.0};
+
+    /// Onset latency of matched notes in milliseconds.
+    double medianLatencyMs{0.0};
+    double p90LatencyMs{0.0};
+    double maxLatencyMs{0.0};
+
+    juce::var toVar() const;
+};
+
+/**
+ *
+ *  @class   Evaluator
+ *  @brief   Renders synthetic plucked string signals, runs them through the
+ *           analysis pipeline offline and scores the detected notes against
+ *           the rendered ones.
+ *
+ */
+class Evaluator {
+public:
+    explicit Evaluator(double sampleRate, int blockSize);
+
+    /**
+     *  @brief  Single notes, chords, bends and fast runs in guitar range.
+     */
+    static std::vector<EvaluationCase> createDefaultCases();
+
+    /**
+     *  @brief  Renders a case with additive synthesis of decaying harmonics
+     *          and a short pick noise burst. Deterministic.
+     */
+    std::vector<float> render(const EvaluationCase &evalCase) const;
+
+    /**
+     *  @brief  Renders a case, processes it block by block and scores the
+     *          result.
+     */
+    EvaluationResult run(const EvaluationCase &evalCase) const;
+
+    /**
+     *  @brief  Compares results to a baseline.
+     *  @param  results  - Results of the current run.
+     *  @param  baseline - Baseline as written by toJson().
+     *  @param  failures - Descriptions of every regression found.
+     *  @retval          - True if nothing regressed.
+     */
+    static bool compareToBaseline(const std::vector<EvaluationResult> &results,
+                                  const juce::var &baseline,
+                                  juce::StringArray &failures);
+
+    static juce::String toJson(const std::vector<EvaluationResult> &results);
+
+private:
+    /// Maximum distance between a detected and a true onset for them to
+    /// match. Detection always lags, so the window is skewed.
+    static constexpr double earlyTolerance{0.025};
+    static constexpr double lateTolerance{0.15};
+
+    /// Allowed deviation from the baseline before a result is a regression.
+    static constexpr double f1Tolerance{0.02};
+    static constexpr double latencyToleranceMs{5.0};
+
+    const double sampleRate_;
+    const int blockSize_;
+};
+
+/**
+ *  @brief  Runs the default evaluation cases and compares them to the
+ *          baseline file, printing results to standard output.
+ *  @param  baselineFile   - JSON baseline to compare to.
+ *  @param  updateBaseline - Overwrite the baseline with this run's results
+ *                           instead of comparing.
+ *  @retval                - True if no case regressed. False if the baseline
+ *                           is missing and not being updated.
+ */
+bool runEvaluation(const juce::File &baselineFile, bool updateBaseline);
+
+} // namespace anyMidi
@@ -0,0 +1,329 @@
+/**
+ *
+ *  @file      FFTBackend.cpp
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#include <array>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <optional>
+
+#include <juce_dsp/juce_dsp.h>
+
+#include "../util/CpuFeatures.h"
+#include "../util/Logger.h"
+#include "FFTBackend.h"
+
+namespace {
+using ButterflyKernel = void (*)(float *, float *, const float *,
+                                 const float *, int);
+
+/**
+ *  @brief Radix-2 decimation in time butterflies over bit reversed input.
+ *         The inner loop runs over contiguous split arrays, so it vectorises
+ *         for whichever target the caller is compiled for.
+ *  @param re  - Real parts.
+ *  @param im  - Imaginary parts.
+ *  @param twr - Real parts of the twiddles of every stage, concatenated.
+ *  @param twi - Imaginary parts of the twiddles.
+ *  @param n   - Number of complex values.
+ */
+forcedinline void butterfliesImpl(float *re, float *im, const float *twr,
+                                  const float *twi, int n) {
+    for (int half = 1; half < n; half *= 2) {
+        for (int start = 0; start < n; start += 2 * half) {
+            float *__restrict ar = re + start;
+            float *__restrict ai = im + start;
+            float *__restrict br = ar + half;
+            float *__restrict bi = ai + half;
+            for (int j = 0; j < half; ++j) {
+                const float tr = twr[j] * br[j] - twi[j] * bi[j];
+                const float ti = twr[j] * bi[j] + twi[j] * br[j];
+                br[j] = ar[j] - tr;
+                bi[j] = ai[j] - ti;
+                ar[j] += tr;
+                ai[j] += ti;
+            }
+        }
+        twr += half;
+        twi += half;
+    }
+}
+
+void butterfliesGeneric(float *re, float *im, const float *twr,
+                        const float *twi, int n) {
+    butterfliesImpl(re, im, twr, twi, n);
+}
+
+#if ANYMIDI_MULTIVERSION
+ANYMIDI_TARGET("avx2,fma")
+void butterfliesAvx2(float *re, float *im, const float *twr, const float *twi,
+                     int n) {
+    butterfliesImpl(re, im, twr, twi, n);
+}
+
+ANYMIDI_TARGET("avx512f")
+void butterfliesAvx512(float *re, float *im, const float *twr,
+                       const float *twi, int n) {
+    butterfliesImpl(re, im, twr, twi, n);
+}
+#endif
+
+/**
+ *
+ *  @class   JuceFFTBackend
+ *  @brief   juce::dsp::FFT behind the backend interface.
+ *
+ */
+class JuceFFTBackend : public anyMidi::FFTBackend {
+public:
+    explicit JuceFFTBackend(int order) : FFTBackend{order}, fft_{order} {}
+
+    void performRealForward(float *data) noexcept override {
+        fft_.performRealOnlyForwardTransform(data, true);
+    }
+
+    juce::String getName() const override { return "JUCE"; }
+
+private:
+    juce::dsp::FFT fft_;
+};
+
+/**
+ *
+ *  @class   Radix2FFTBackend
+ *  @brief   Packs even and odd samples into one complex signal of half the
+ *           size, transforms it and splits the result into the spectrum of
+ *           the real signal.
+ *
+ */
+class Radix2FFTBackend : public anyMidi::FFTBackend {
+public:
+    explicit Radix2FFTBackend(int order)
+        : FFTBackend{order}, half_{getSize() / 2},
+          re_(static_cast<std::size_t>(half_)),
+          im_(static_cast<std::size_t>(half_)),
+          reversed_(static_cast<std::size_t>(half_)) {
+        const double twoPi = juce::MathConstants<double>::twoPi;
+
+        // Bit reversal permutation of the half size transform.
+        int bits{0};
+        while ((1 << bits) < half_) {
+            ++bits;
+        }
+        for (int i = 0; i < half_; ++i) {
+            int r{0};
+            for (int b = 0; b < bits; ++b) {
+                r |= ((i >> b) & 1) << (bits - 1 - b);
+            }
+            reversed_[static_cast<std::size_t>(i)] = r;
+        }
+
+        // Twiddles of every butterfly stage, one after another.
+        for (int half = 1; half < half_; half *= 2) {
+            for (int j = 0; j < half; ++j) {
+                const double angle = -twoPi * j / (2.0 * half);
+                stageRe_.push_back(static_cast<float>(std::cos(angle)));
+                stageIm_.push_back(static_cast<float>(std::sin(angle)));
+            }
+        }
+
+        // Twiddles of the split into the real spectrum.
+        for (int k = 0; k < half_; ++k) {
+            const double angle = -twoPi * k / getSize();
+            splitRe_.push_back(static_cast<float>(std::cos(angle)));
+            splitIm_.push_back(static_cast<float>(std::sin(angle)));
+        }
+
+        const auto level = anyMidi::getSimdLevel();
+        isaName_ = anyMidi::getSimdLevelName(level);
+        kernel_ = butterfliesGeneric;
+#if ANYMIDI_MULTIVERSION
+        if (level == anyMidi::SimdLevel::AVX512) {
+            kernel_ = butterfliesAvx512;
+        } else if (level == anyMidi::SimdLevel::AVX2) {
+            kernel_ = butterfliesAvx2;
+        }
+#endif
+    }
+
+    void performRealForward(float *data) noexcept override {
+        // Even samples become real parts and odd samples imaginary parts,
+        // loaded in bit reversed order.
+        for (int i = 0; i < half_; ++i) {
+            const auto r = static_cast<std::size_t>(reversed_[i]);
+            re_[r] = data[2 * i];
+            im_[r] = data[2 * i + 1];
+        }
+
+        kernel_(re_.data(), im_.data(), stageRe_.data(), stageIm_.data(),
+                half_);
+
+        // Bins 0 and N/2 are real.
+        data[0] = re_[0] + im_[0];
+        data[1] = 0.0F;
+        data[2 * half_] = re_[0] - im_[0];
+        data[2 * half_ + 1] = 0.0F;
+
+        // X[k] = E[k] + W^k O[k], where E and O are the spectra of the even
+        // and odd samples, recovered from Z[k] and conj(Z[N/2 - k]).
+        for (int k = 1; k < half_; ++k) {
+            const auto a = static_cast<std::size_t>(k);
+            const auto b = static_cast<std::size_t>(half_ - k);
+            const float evenRe = 0.5F * (re_[a] + re_[b]);
+            const float evenIm = 0.5F * (im_[a] - im_[b]);
+            const float oddRe = 0.5F * (im_[a] + im_[b]);
+            const float oddIm = -0.5F * (re_[a] - re_[b]);
+            const float wr = splitRe_[a];
+            const float wi = splitIm_[a];
+            data[2 * k] = evenRe + wr * oddRe - wi * oddIm;
+            data[2 * k + 1] = evenIm + wr * oddIm + wi * oddRe;
+        }
+    }
+
+    juce::String getName() const override {
+        return juce::String{"Radix-2 ("} + isaName_ + ")";
+    }
+
+private:
+    const int half_;
+    std::vector<float> re_;
+    std::vector<float> im_;
+    std::vector<int> reversed_;
+    std::vector<float> stageRe_;
+    std::vector<float> stageIm_;
+    std::vector<float> splitRe_;
+    std::vector<float> splitIm_;
+
+    ButterflyKernel kernel_;
+    const char *isaName_;
+};
+
+using BackendFactory = std::unique_ptr<anyMidi::FFTBackend> (*)(int);
+
+const std::array<BackendFactory, 2> factories{
+    anyMidi::createJuceFFTBackend, anyMidi::createRadix2FFTBackend};
+/// Names of the factories' backends, without the instruction set.
+const std::array<const char *, 2> factoryNames{"JUCE", "Radix-2"};
+
+constexpr int defaultBenchmarkIterations{200};
+
+/// Guards the backend choices.
+std::mutex choiceMutex;
+/// Factory of the fastest backend, by order.
+std::map<int, std::size_t> fastest;
+/// Factory used for every order instead, see pinFFTBackend().
+std::optional<std::size_t> pinned;
+} // namespace
+
+std::unique_ptr<anyMidi::FFTBackend> anyMidi::createJuceFFTBackend(int order) {
+    return std::make_unique<JuceFFTBackend>(order);
+}
+
+std::unique_ptr<anyMidi::FFTBackend>
+anyMidi::createRadix2FFTBackend(int order) {
+    return std::make_unique<Radix2FFTBackend>(order);
+}
+
+std::vector<anyMidi::FFTBenchmarkResult>
+anyMidi::benchmarkFFTBackends(int order, int iterations) {
+    const int size = 1 << order;
+    std::vector<float> input(static_cast<std::size_t>(size));
+    std::vector<float> data(static_cast<std::size_t>(size) * 2);
+
+    juce::Random random{1};
+    for (auto &sample : input) {
+        sample = random.nextFloat() * 2.0F - 1.0F;
+    }
+
+    constexpr int warmUpIterations{10};
+    constexpr double nanosecondsPerSecond{1e9};
+
+    std::vector<FFTBenchmarkResult> results;
+    for (const auto factory : factories) {
+        auto backend = factory(order);
+        for (int i = 0; i < warmUpIterations; ++i) {
+            std::copy(input.begin(), input.end(), data.begin());
+            backend->performRealForward(data.data());
+        }
+
+        const auto start = juce::Time::getHighResolutionTicks();
+        for (int i = 0; i < iterations; ++i) {
+            std::copy(input.begin(), input.end(), data.begin());
+            backend->performRealForward(data.data());
+        }
+        const auto elapsed = juce::Time::highResolutionTicksToSeconds(
+            juce::Time::getHighResolutionTicks() - start);
+
+        results.push_back({backend->getName(),
+                           elapsed * nanosecondsPerSecond / iterations});
+    }
+    return results;
+}
+
+std::unique_ptr<anyMidi::FFTBackend> anyMidi::createFFTBackend(int order) {
+    const std::scoped_lock lock{choiceMutex};
+    if (pinned.has_value()) {
+        return factories[*pinned](order);
+    }
+
+    auto choice = fastest.find(order);
+    if (choice == fastest.end()) {
+        const auto results =
+            benchmarkFFTBackends(order, defaultBenchmarkIterations);
+        std::size_t best{0};
+        for (std::size_t i = 1; i < results.size(); ++i) {
+            if (results[i].nanosecondsPerTransform <
+                results[best].nanosecondsPerTransform) {
+                best = i;
+            }
+        }
+        choice = fastest.emplace(order, best).first;
+
+        anyMidi::log(LogLevel::Info, "FFT size {} uses {} backend ({:.0f} ns)",
+                     1 << order, results[best].name.toRawUTF8(),
+                     results[best].nanosecondsPerTransform);
+    }
+    return factories[choice->second](order);
+}
+
+bool anyMidi::pinFFTBackend(const juce::String &name) {
+    const std::scoped_lock lock{choiceMutex};
+    if (name.isEmpty()) {
+        pinned.reset();
+        return true;
+    }
+
+    const auto family = name.upToFirstOccurrenceOf(" (", false, false);
+    for (std::size_t i = 0; i < factoryNames.size(); ++i) {
+        if (family == factoryNames[i]) {
+            pinned = i;
+            anyMidi::log(LogLevel::Info, "FFT backend pinned to {}",
+                         factoryNames[i]);
+            return true;
+        }
+    }
+    return false;
+}
+
+void anyMidi::printFFTBenchmark() {
+    constexpr int minOrder{8};
+    constexpr int maxOrder{14};
+    constexpr int iterations{1000};
+    constexpr double nanosecondsPerMicrosecond{1000.0};
+
+    for (int order = minOrder; order <= maxOrder; ++order) {
+        std::cout << "FFT size " << (1 << order) << "\n";
+        for (const auto &result : benchmarkFFTBackends(order, iterations)) {
+            std::cout << "  " << result.name << ": "
+                      << result.nanosecondsPerTransform /
+                             nanosecondsPerMicrosecond
+                      << " us\n";
+        }
+    }
+}
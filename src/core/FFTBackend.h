@@ -0,0 +1,113 @@
+/**
+ *
+ *  @file      FFTBackend.h
+ *  @brief     Interchangeable real-input FFT implementations.
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <juce_core/juce_core.h>
+
+namespace anyMidi {
+
+/**
+ *
+ *  @class   FFTBackend
+ *  @brief   Forward transform of real samples, with the same layout as
+ *           juce::dsp::FFT::performRealOnlyForwardTransform() when only the
+ *           non-negative frequencies are calculated.
+ *
+ */
+class FFTBackend {
+public:
+    explicit FFTBackend(int order) : size_{1 << order} {}
+    virtual ~FFTBackend() = default;
+
+    /**
+     *  @brief Transforms getSize() real samples in place.
+     *  @param data - Array of getSize() * 2 floats, with the samples in the
+     *                first half. Holds getSize() / 2 + 1 interleaved complex
+     *                bins on return. Not normalised.
+     */
+    virtual void performRealForward(float *data) noexcept = 0;
+
+    /**
+     *  @brief  Name of the implementation, including the instruction set
+     *          chosen for this CPU.
+     */
+    virtual juce::String getName() const = 0;
+
+    int getSize() const { return size_; }
+
+private:
+    const int size_;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FFTBackend)
+};
+
+/**
+ *  @brief Wraps juce::dsp::FFT, whichever engine JUCE picks on the platform.
+ */
+std::unique_ptr<FFTBackend> createJuceFFTBackend(int order);
+
+/**
+ *  @brief Real FFT computed as a complex FFT of half the size, with radix-2
+ *         butterflies on split real and imaginary arrays. The butterflies are
+ *         compiled for AVX-512, AVX2 and generic targets, and the best one
+ *         the CPU supports is chosen at construction.
+ */
+std::unique_ptr<FFTBackend> createRadix2FFTBackend(int order);
+
+/**
+ *
+ *  @struct  FFTBenchmarkResult
+ *  @brief   Time per transform of a backend.
+ *
+ */
+struct FFTBenchmarkResult {
+    juce::String name;
+    double nanosecondsPerTransform{0.0};
+};
+
+/**
+ *  @brief  Times every backend on the same noise.
+ *  @param  order      - Base 2 logarithm of the FFT size.
+ *  @param  iterations - Number of timed transforms per backend.
+ *  @retval            - Results in the order backends are created.
+ */
+std::vector<FFTBenchmarkResult> benchmarkFFTBackends(int order,
+                                                     int iterations);
+
+/**
+ *  @brief  Creates the fastest backend for an FFT size, or the pinned one.
+ *          Backends are benchmarked the first time a size is requested, and
+ *          the choice is remembered. Must not be called from the audio
+ *          thread.
+ */
+std::unique_ptr<FFTBackend> createFFTBackend(int order);
+
+/**
+ *  @brief  Makes createFFTBackend() create one backend instead of the fastest,
+ *          so that offline runs do not depend on timing. The backends round
+ *          differently, so their notes can differ.
+ *  @param  name - Name as returned by FFTBackend::getName(). The instruction
+ *                 set in parentheses is left to the CPU. Empty to go back to
+ *                 the fastest.
+ *  @retval      - False if no backend has the name.
+ */
+bool pinFFTBackend(const juce::String &name);
+
+/**
+ *  @brief  Prints benchmark results for a range of FFT sizes to standard
+ *          output.
+ */
+void printFFTBenchmark();
+
+} // namespace anyMidi
@@ -11,30 +11,98 @@
 
 #include "../util/Globals.h"
 
+namespace {
+/**
+ *  @brief Magnitudes of interleaved complex values, four at a time where SIMD
+ *         is available.
+ *  @param complex   - Interleaved real and imaginary parts.
+ *  @param magnitude - Destination, must not overlap complex.
+ *  @param num       - Number of complex values.
+ */
+void computeMagnitudes(const float *complex, float *magnitude,
+                       std::size_t num) {
+    std::size_t i{0};
+#if JUCE_USE_SSE_INTRINSICS
+    for (; i + 4 <= num; i += 4) {
+        const __m128 lo = _mm_loadu_ps(complex + 2 * i);
+        const __m128 hi = _mm_loadu_ps(complex + 2 * i + 4);
+        const __m128 re = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128 im = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(magnitude + i,
+                      _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(re, re),
+                                             _mm_mul_ps(im, im))));
+    }
+#elif JUCE_USE_ARM_NEON && JUCE_64BIT
+    for (; i + 4 <= num; i += 4) {
+        const float32x4x2_t c = vld2q_f32(complex + 2 * i);
+        const float32x4_t squared =
+            vmlaq_f32(vmulq_f32(c.val[0], c.val[0]), c.val[1], c.val[1]);
+        vst1q_f32(magnitude + i, vsqrtq_f32(squared));
+    }
+#endif
+    for (; i < num; ++i) {
+        magnitude[i] = std::hypot(complex[2 * i], complex[2 * i + 1]);
+    }
+}
+} // namespace
+
 anyMidi::ForwardFFT::ForwardFFT(
+    const int order, const double sampleRate,
+    const juce::dsp::WindowingFunction<float>::WindowingMethod windowingMethod)
+    : fftSize_{1 << order}, sampleRate_{sampleRate}, sliding_{1 << order},
+      winMethod_{windowingMethod} {}
+
+template <int Order>
+anyMidi::SizedForwardFFT<Order>::SizedForwardFFT(
     const double sampleRate,
     const juce::dsp::WindowingFunction<float>::WindowingMethod windowingMethod)
-    : forwardFFT_{fftOrder}, sampleRate_{sampleRate},
-      // When initialising the windowing function, consider using fftSize + 1,
-      // ref. https://artandlogic.com/2019/11/making-spectrograms-in-juce/amp/
-      window_{fftSize + 1, windowingMethod}, winMethod_{windowingMethod} {
-    windowCompensation_ = windowCompensations_.at(windowingMethod);
+    : ForwardFFT{Order, sampleRate, windowingMethod},
+      noiseFloor_{numBins, sampleRate / fftSize},
+      forwardFFT_{createFFTBackend(Order)} {
+    fillWindowTable(windowingMethod);
 }
 
-std::array<float, anyMidi::ForwardFFT::fftSize * 2>
-anyMidi::ForwardFFT::getFFTData() const {
-    return fftData_;
+template <int Order>
+void anyMidi::SizedForwardFFT<Order>::fillWindowTable(
+    juce::dsp::WindowingFunction<float>::WindowingMethod method) {
+    for (std::size_t i = 0; i < windowTables_.size(); ++i) {
+        const std::size_t length = fftSize >> i;
+
+        // When initialising the windowing function, consider using
+        // fftSize + 1, ref.
+        // https://artandlogic.com/2019/11/making-spectrograms-in-juce/amp/
+        juce::dsp::WindowingFunction<float>::fillWindowingTables(
+            windowScratch_.data(), length + 1, method);
+
+        // A sinusoid's peak grows with the frame length, so shorter frames
+        // are scaled up to match full ones.
+        juce::FloatVectorOperations::multiply(
+            windowTables_[i].data(), windowScratch_.data(),
+            windowCompensations_.at(method) * static_cast<float>(fftSize) /
+                static_cast<float>(length),
+            static_cast<int>(length));
+    }
 }
 
-int anyMidi::ForwardFFT::getFFTSize() { return fftSize; }
+template <int Order>
+void anyMidi::SizedForwardFFT<Order>::setFrameLength(int numSamples) {
+    std::size_t index{0};
+    while (index + 1 < static_cast<std::size_t>(numFrameLengths) &&
+           static_cast<int>(fftSize >> (index + 1)) >= numSamples) {
+        ++index;
+    }
+    frameLengthIndex_ = static_cast<int>(index);
+    frameLength_ = static_cast<int>(fftSize >> index);
+}
 
-void anyMidi::ForwardFFT::setWindowingFunction(const int &id) {
+template <int Order>
+void anyMidi::SizedForwardFFT<Order>::setWindowingFunction(const int &id) {
     auto winMethod =
         static_cast<juce::dsp::WindowingFunction<float>::WindowingMethod>(id);
 
     this->winMethod_ = winMethod;
-    this->windowCompensation_ = windowCompensations_.at(winMethod);
-    this->window_.fillWindowingTables(fftSize + 1, winMethod);
+    fillWindowTable(winMethod);
+    this->noiseFloor_.reset();
 }
 
 juce::Array<juce::String>
@@ -89,194 +157,236 @@ anyMidi::ForwardFFT::getAvailableWindowingMethods() const {
     return windowStrings;
 }
 
-void anyMidi::ForwardFFT::pushNextSampleIntoFifo(float sample) {
-    // When fifo contains enough data, flag is set to say next frame should be
-    // rendered.
-    if (fifoIndex_ == fftSize) {
-        if (!nextFFTBlockReady_) {
-            // Initializes fftData with zeroes.
-            std::fill(fftData_.begin(), fftData_.end(), 0.0F);
-            // Copies the data from the fifo into fftData.
-            std::copy(fifo_.begin(), fifo_.end(), fftData_.begin());
-            // Sets flag.
-            nextFFTBlockReady_ = true;
-
-            // Perform windowing and forward FFT.
-            window_.multiplyWithWindowingTable(fftData_.data(), fftSize);
-            forwardFFT_.performFrequencyOnlyForwardTransform(fftData_.data());
-
-            // Amplitude compensation for window function.
-            juce::FloatVectorOperationsBase<float, size_t>::multiply(
-                fftData_.data(), windowCompensation_, fftSize);
+template <int Order>
+int anyMidi::SizedForwardFFT<Order>::pushSamples(const float *samples,
+                                                 int numSamples) {
+    for (int i = 0; i < numSamples; ++i) {
+        pushNextSampleIntoFifo(samples[i]);
+        if (nextFFTBlockReady_) {
+            return i + 1;
         }
-
-        fifoIndex_ = 0;
     }
-
-    fifo_.at(fifoIndex_++) = sample;
+    return numSamples;
 }
 
-std::pair<double, double> anyMidi::ForwardFFT::calcFundamentalFreq() const {
-    double max{0};
-    unsigned int targetBin{0}; // Location of fund. freq. will be stored here.
-    auto data = getFFTData();
+template <int Order>
+void anyMidi::SizedForwardFFT<Order>::pushNextSampleIntoFifo(float sample) {
+    fifo_[static_cast<std::size_t>(fifoIndex_)] = sample;
+    fifoIndex_ = (fifoIndex_ + 1) & static_cast<int>(fftSize - 1);
+    sliding_.push(sample);
 
-    // Finds fft bin with most energy.
-    for (int i = 0; i < getFFTSize(); ++i) {
-        if (max < data.at(i)) {
-            max = data.at(i);
-            targetBin = i;
-        }
+    // When the frame is complete, flag is set to say it should be rendered.
+    if (++samplesSinceFrame_ < frameLength_) {
+        return;
+    }
+    samplesSinceFrame_ = 0;
+    if (nextFFTBlockReady_ || !analysisEnabled_) {
+        return;
     }
 
-    // Calculates frequency from bin number and accesses amplitude at bin
-    // number.
-    auto fundamental = std::make_pair<double, double>(
-        static_cast<double>(targetBin * sampleRate_ / (fftSize * 2)),
-        static_cast<double>((data.at(targetBin) / fftSize)));
-    return fundamental;
-}
-
-std::vector<std::pair<int, double>>
-anyMidi::ForwardFFT::getHarmonics(const unsigned int &numPartials,
-                                  const std::vector<double> &noteFreq) const {
-    auto data = getFFTData();
-    cleanUpBins(data);
-    auto notes = mapBinsToNotes(noteFreq, data);
-    return determineHarmonics(numPartials, notes);
+    const ScopedStageTimer timer{telemetry_, Stage::FFT};
+
+    // Windows and compensates the latest samples straight into the FFT
+    // input, in two parts where they wrap around the FIFO. A short frame is
+    // zero padded. The transform only reads the first half, so the rest is
+    // not cleared.
+    const int length = frameLength_;
+    const int start = (fifoIndex_ + static_cast<int>(fftSize) - length) &
+                      static_cast<int>(fftSize - 1);
+    const int first = std::min(length, static_cast<int>(fftSize) - start);
+    const float *window =
+        windowTables_[static_cast<std::size_t>(frameLengthIndex_)].data();
+    juce::FloatVectorOperations::multiply(fftData_.data(), fifo_.data() + start,
+                                          window, first);
+    juce::FloatVectorOperations::multiply(fftData_.data() + first,
+                                          fifo_.data(), window + first,
+                                          length - first);
+    juce::FloatVectorOperations::clear(fftData_.data() + length,
+                                       static_cast<int>(fftSize) - length);
+    // Sets flag.
+    nextFFTBlockReady_ = true;
+
+    // Forward FFT of the non-negative frequencies only.
+    forwardFFT_->performRealForward(fftData_.data());
+
+    computeMagnitudes(fftData_.data(), magnitudes_.data(), numBins);
 }
 
-int anyMidi::ForwardFFT::getWindowingFunction() const { return winMethod_; }
-
-void anyMidi::ForwardFFT::cleanUpBins(std::array<float, fftSize * 2> &data) {
-    constexpr double kThreshold{1.0};
-
-    std::vector<int> lobes;
-    for (int bin = 0; bin < getFFTSize(); ++bin) {
-        // Clean up noise - acts like a gate.
-        if (data.at(bin) < kThreshold) {
-            data.at(bin) = 0;
-        } else {
-            // Adds bin as part of a lobe when above threshold.
-            lobes.push_back(bin);
-        }
-
-        // When bin is zero, we've moved past the lobe and it can be analyzed.
-        // Squeezes lobe into a single bin, being the center bin of the lobe.
-        if (!lobes.empty() && data.at(bin) == 0) {
-            float maxLobe{0.0};
-            int ctrBin{0};
-            for (const int i : lobes) {
-                if (data.at(i) > maxLobe) {
-                    ctrBin = i;
-                    maxLobe = data.at(i);
-                }
-            }
-
-            for (const int i : lobes) {
-                // Adds all amplitudes to center bin.
-                if (i != ctrBin) {
-                    data.at(ctrBin) += data.at(i);
-                    data.at(i) = 0;
-                }
-            }
-            lobes.clear();
-        }
+template <int Order>
+const float *anyMidi::SizedForwardFFT<Order>::getCleanSpectrum() {
+    const ScopedStageTimer timer{telemetry_, Stage::CleanUpBins};
+    frameFloors_ = noiseFloor_.getFloors();
+    if (frameLength_ == static_cast<int>(fftSize)) {
+        noiseFloor_.update(magnitudes_.data());
+    } else {
+        // Scaled up to full frame amplitudes, the noise of a short frame
+        // rises with the square root of the scale. The floor is learned from
+        // full frames only.
+        juce::FloatVectorOperations::multiply(
+            scaledFloors_.data(), frameFloors_,
+            std::sqrt(static_cast<float>(fftSize) /
+                      static_cast<float>(frameLength_)),
+            static_cast<int>(numBins));
+        frameFloors_ = scaledFloors_.data();
     }
+    cleaned_ = magnitudes_;
+    cleanUpBins(cleaned_, frameFloors_);
+    return cleaned_.data();
 }
 
-std::vector<double> anyMidi::ForwardFFT::mapBinsToNotes(
-    const std::vector<double> &noteFreq,
-    const std::array<float, fftSize * 2UL> &data) const {
-    // Determines closest note to all bins in FFT and maps bins to their correct
-    // frequencies. The amplitudes of each bin is added onto the notes
-    // amplitude.
-    std::vector<double> amps(noteFreq.size());
-    for (int bin = 1; bin < getFFTSize(); ++bin) {
-        const auto freq =
-            static_cast<double>(bin * sampleRate_ / (fftSize * 2));
-        auto note = anyMidi::findNearestNote(freq, noteFreq);
-
-        amps[note] += data.at(bin);
-    }
+template <int Order>
+const anyMidi::PeakTable &
+anyMidi::SizedForwardFFT<Order>::findPeaks(const double fundamental,
+                                           const int numHarmonics) {
+    const ScopedStageTimer timer{telemetry_, Stage::Peaks};
+    peaks_.build(cleaned_.data(), magnitudes_.data(), frameFloors_,
+                 static_cast<int>(numBins), getBinWidth(), 1.0F / fftSize);
+    peaks_.assignHarmonics(fundamental, numHarmonics);
+    return peaks_;
+}
 
-    return amps;
+template <int Order>
+double
+anyMidi::SizedForwardFFT<Order>::getNoiseAmplitude(double frequency) const {
+    const auto bin = static_cast<std::size_t>(juce::jlimit(
+        0, static_cast<int>(numBins) - 1,
+        static_cast<int>(std::round(frequency / getBinWidth()))));
+    return static_cast<double>(frameFloors_[bin]) / fftSize;
 }
 
-std::vector<std::pair<int, double>>
-anyMidi::ForwardFFT::determineHarmonics(const unsigned int &numPartials,
-                                        std::vector<double> &amps) {
-    // Thanks to
-    // https://stackoverflow.com/questions/14902876/indices-of-the-k-largest-elements-in-an-unsorted-length-n-array/38391603#38391603
-    // for inspiration for this algorithm.
-
-    // Stores bin index and value for the n loudest partials.
-    std::priority_queue<std::pair<double, int>,
-                        std::vector<std::pair<double, int>>, std::greater<>>
-        queue;
-
-    // Puts the loudest bins into the priority queue, storing the amplitude and
-    // the index.
-    for (int i = 0; i < amps.size(); ++i) {
-        if (queue.size() < numPartials) {
-            queue.emplace(amps[i], i);
-        } else if (queue.top().first < amps[i]) {
-            queue.pop();
-            queue.emplace(amps[i], i);
-        }
+template <int Order>
+float anyMidi::SizedForwardFFT<Order>::measureChange(float &gain) const {
+    float total{0.0F};
+    float referenceTotal{0.0F};
+    for (std::size_t bin = 0; bin < numBins; ++bin) {
+        total += magnitudes_[bin];
+        referenceTotal += reference_[bin];
+    }
+    if (total <= 0.0F || referenceTotal <= 0.0F) {
+        gain = 1.0F;
+        return 1.0F;
     }
 
-    // Transforms the priority queue into a variable size vector, since the
-    // number of partials may change.
-    auto k = queue.size();
-    std::vector<std::pair<int, double>> harmonics;
-    for (int i = 0; i < k; ++i) {
-        // Creates pair of {frequenzy, amplitude}.
-        harmonics.emplace_back(queue.top().second, queue.top().first / fftSize);
-        queue.pop();
+    gain = total / referenceTotal;
+    float difference{0.0F};
+    for (std::size_t bin = 0; bin < numBins; ++bin) {
+        difference += std::abs(magnitudes_[bin] - gain * reference_[bin]);
     }
+    return difference / total;
+}
 
-    // Sorts harmonics based on lowest frequency.
-    std::sort(harmonics.begin(), harmonics.end(),
-              [](std::pair<int, double> a, std::pair<int, double> b) {
-                  return a.first < b.first;
-              });
+double
+anyMidi::ForwardFFT::estimateFrequency(const double &nominal,
+                                       const unsigned int &numHarmonics) const {
+    const float *magnitudes = getMagnitudes();
+    const double binWidth = getBinWidth();
+    // Searches half a semitone to each side of the harmonic.
+    const double searchRatio = std::pow(2.0, 1.0 / 24.0);
+    constexpr float minMagnitude{1e-9F};
+
+    double weightedSum{0.0};
+    double totalWeight{0.0};
+    for (unsigned int h = 1; h <= numHarmonics; ++h) {
+        const double target = nominal * h;
+        const int first = std::max(
+            1, static_cast<int>(std::floor(target / searchRatio / binWidth)));
+        const int last = std::min(
+            getNumBins() - 2,
+            static_cast<int>(std::ceil(target * searchRatio / binWidth)));
+        if (first > last) {
+            break;
+        }
 
-    return harmonics;
-}
+        int peak{first};
+        for (int bin = first + 1; bin <= last; ++bin) {
+            if (magnitudes[bin] > magnitudes[peak]) {
+                peak = bin;
+            }
+        }
 
-int anyMidi::findNearestNote(const double &target,
-                             const std::vector<double> &noteFrequencies) {
-    int begin{0};
-    auto end = static_cast<int>(noteFrequencies.size());
+        // Rejects the edge of the search range when it is not a true peak.
+        const float centre = magnitudes[peak];
+        if (centre <= minMagnitude || centre < magnitudes[peak - 1] ||
+            centre < magnitudes[peak + 1]) {
+            continue;
+        }
 
-    // When frequency is below or above highest midi note.
-    if (target <= noteFrequencies[begin]) {
-        return begin;
-    }
-    if (target >= noteFrequencies[end - 1]) {
-        return end - 1;
+        const double a = std::log(std::max(magnitudes[peak - 1], minMagnitude));
+        const double b = std::log(centre);
+        const double c = std::log(std::max(magnitudes[peak + 1], minMagnitude));
+        const double denominator = a - 2.0 * b + c;
+        const double offset =
+            denominator < 0.0 ? 0.5 * (a - c) / denominator : 0.0;
+
+        // Higher harmonics pin down the fundamental more precisely.
+        const double weight = static_cast<double>(centre) * h;
+        weightedSum += (peak + offset) * binWidth / h * weight;
+        totalWeight += weight;
     }
 
-    // Variation of binary search.
-    int mid{0};
-    while (end - begin > 1) {
-        mid = begin + (end - begin) / 2;
+    return totalWeight > 0.0 ? weightedSum / totalWeight : nominal;
+}
 
-        if (target == noteFrequencies[mid]) {
-            return mid;
-        }
-        if (target < noteFrequencies[mid]) {
-            end = mid;
+template <int Order>
+void anyMidi::SizedForwardFFT<Order>::cleanUpBins(Spectrum &data,
+                                                  const float *floors) {
+    // Lobes are runs of bins above the threshold, so a lobe is tracked by
+    // the bin it starts at and its loudest bin so far.
+    std::size_t lobeStart{0};
+    std::size_t ctrBin{0};
+    bool inLobe{false};
+    for (std::size_t bin = 0; bin < numBins; ++bin) {
+        // Clean up noise - acts like a gate relative to the noise floor.
+        if (data[bin] < std::max(minThreshold, floors[bin] * gateRatio)) {
+            data[bin] = 0;
         } else {
-            begin = mid;
+            // Adds bin as part of a lobe when above threshold.
+            if (!inLobe) {
+                inLobe = true;
+                lobeStart = bin;
+                ctrBin = bin;
+            } else if (data[bin] > data[ctrBin]) {
+                ctrBin = bin;
+            }
+            continue;
         }
-    }
 
-    if (std::abs(target - noteFrequencies[begin]) <
-        std::abs(target - noteFrequencies[end])) {
-        return begin;
+        // When bin is zero, we've moved past the lobe and it can be analyzed.
+        // Squeezes lobe into a single bin, being the center bin of the lobe.
+        if (inLobe) {
+            for (std::size_t i = lobeStart; i < bin; ++i) {
+                // Adds all amplitudes to center bin.
+                if (i != ctrBin) {
+                    data[ctrBin] += data[i];
+                    data[i] = 0;
+                }
+            }
+            inLobe = false;
+        }
     }
+}
 
-    return end;
-}
\ No newline at end of file
+template class anyMidi::SizedForwardFFT<9>;
+template class anyMidi::SizedForwardFFT<10>;
+template class anyMidi::SizedForwardFFT<11>;
+template class anyMidi::SizedForwardFFT<12>;
+
+std::unique_ptr<anyMidi::ForwardFFT> anyMidi::createForwardFFT(
+    int order, double sampleRate,
+    juce::dsp::WindowingFunction<float>::WindowingMethod windowingMethod) {
+
+    switch (juce::jlimit(ForwardFFT::minOrder, ForwardFFT::maxOrder, order)) {
+    case 9:
+        return std::make_unique<SizedForwardFFT<9>>(sampleRate,
+                                                    windowingMethod);
+    case 10:
+        return std::make_unique<SizedForwardFFT<10>>(sampleRate,
+                                                     windowingMethod);
+    case 11:
+        return std::make_unique<SizedForwardFFT<11>>(sampleRate,
+                                                     windowingMethod);
+    default:
+        return std::make_unique<SizedForwardFFT<12>>(sampleRate,
+                                                     windowingMethod);
+    }
+}
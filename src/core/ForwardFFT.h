@@ -10,42 +10,109 @@
 
 #pragma once
 
+#include <array>
+#include <memory>
+
 #include <juce_core/juce_core.h>
 #include <juce_dsp/juce_dsp.h>
 
+#include "FFTBackend.h"
+#include "NoiseFloor.h"
+#include "PeakTable.h"
+#include "SlidingDft.h"
+#include "Telemetry.h"
+
 namespace anyMidi {
 
+/**
+ *
+ *  @class   ForwardFFT
+ *  @brief   Frame analysis common to every FFT size. The bin loops depend on
+ *           the size and are compiled once for each supported order by
+ *           SizedForwardFFT. createForwardFFT() picks one at runtime, and the
+ *           pipeline only calls into it once per block and per frame.
+ *
+ */
 class ForwardFFT {
-private:
-    /// Used as exponent of base 2 in FFT size.
-    static constexpr size_t fftOrder{10};
-    /// 2 to the power of FFT order.
-    static constexpr size_t fftSize = 1UL << fftOrder;
+public:
+    /// Orders compiled in, from 512 to 4096 bins.
+    static constexpr int minOrder{9};
+    static constexpr int maxOrder{12};
+    static constexpr int defaultOrder{10};
 
-    /// Signals whether the FIFO has been copied into the FFT array.
-    bool nextFFTBlockReady_ = false;
+    /// Frame lengths from the FFT size down by halves, see setFrameLength().
+    static constexpr int numFrameLengths{3};
+
+    virtual ~ForwardFFT() = default;
+
+    int getFFTSize() const { return fftSize_; }
 
-public:
     /**
-     *  @brief ForwardFFT object constructor
-     *  @param sampleRate      - Audio sample rate to use for the FFT.
-     *  @param windowingMethod - Windowing method to use for the FFT.
+     *  @brief  Frequency spacing in Hz between the bins used for note mapping.
+     *          Half the true spacing, so notes map an octave below the played
+     *          pitch. MidiProcessor::createMidiMsg() shifts them back up.
      */
-    ForwardFFT(
-        double sampleRate,
-        juce::dsp::WindowingFunction<float>::WindowingMethod windowingMethod);
+    double getBinWidth() const { return sampleRate_ / (fftSize_ * 2); }
 
-    static int getFFTSize();
+    /**
+     *  @brief  Number of bins of the non-negative frequencies, the only ones
+     *          of a real signal's spectrum that are not reflections.
+     */
+    int getNumBins() const { return fftSize_ / 2 + 1; }
 
-    std::array<float, fftSize * 2> getFFTData() const;
+    /**
+     *  @brief  Magnitudes of the getNumBins() bins of the last transformed
+     *          frame, without copying.
+     */
+    virtual const float *getMagnitudes() const = 0;
 
     bool isNextFFTBlockReady() const { return nextFFTBlockReady_; }
 
     void setNextFFTBlockReady(const bool ready) { nextFFTBlockReady_ = ready; }
 
-    int getWindowingFunction() const;
+    /**
+     *  @brief Shortens the frames, for notes whose harmonics a shorter window
+     *         resolves. A frame is then the latest samples of the FIFO,
+     *         windowed and zero padded to the FFT size, so its bins are laid
+     *         out as for a full frame. Frames follow each other by their
+     *         length, so shorter frames also come sooner.
+     *  @param numSamples - Shortest length wanted, rounded up to a power of
+     *                      two between getMinFrameLength() and the FFT size.
+     */
+    virtual void setFrameLength(int numSamples) = 0;
 
-    void setWindowingFunction(const int &id);
+    virtual int getFrameLength() const = 0;
+
+    /**
+     *  @brief  Name of the FFT backend the transform runs on.
+     */
+    virtual juce::String getBackendName() const = 0;
+
+    int getMinFrameLength() const {
+        return fftSize_ >> (numFrameLengths - 1);
+    }
+
+    /**
+     *  @brief Partials followed between frames. Fed every sample pushed into
+     *         the FIFO.
+     */
+    SlidingDft &getSlidingDft() { return sliding_; }
+
+    /**
+     *  @brief Turns transforming of full frames on or off. While off, samples
+     *         still fill the FIFO, so the first frame after turning it back
+     *         on holds the samples leading up to it.
+     */
+    void setAnalysisEnabled(bool enabled) { analysisEnabled_ = enabled; }
+
+    int getWindowingFunction() const { return winMethod_; }
+
+    virtual void setWindowingFunction(const int &id) = 0;
+
+    /**
+     *  @brief Sets where stage timings are recorded. Null disables timing.
+     */
+    void setTelemetry(Telemetry *telemetry) { telemetry_ = telemetry; }
 
     /**
      *  @brief  Used to initialize UI with possible windowing methods.
@@ -54,77 +121,98 @@ public:
     juce::Array<juce::String> getAvailableWindowingMethods() const;
 
     /**
-     *  @brief Fills the FIFO with samples and initiates FFT on the sample when
-     *         the FIFO is full.
-     *  @param sample - The sample to be stored in the FIFO.
+     *  @brief  Fills the FIFO with samples, transforming each frame as it
+     *          completes. Stops after the sample that completes a frame, so
+     *          it can be analysed before the next one starts.
+     *  @param  samples    - Samples to store in the FIFO.
+     *  @param  numSamples - Number of samples.
+     *  @retval            - Number of samples stored.
      */
-    void pushNextSampleIntoFifo(float sample);
+    virtual int pushSamples(const float *samples, int numSamples) = 0;
 
     /**
-     *  @brief  Quick and dirty calculation of the fundamental frequency of the
-     *          current FFT data array. Only consideres the loudest bin, and is
-     *          therefore deprecated.
-     *  @retval  - Pair of the fundamental frequency and its amplitude.
+     *  @brief  Updates the noise floor with the current frame and gates it,
+     *          zeroing bins that do not stand out from the floor and
+     *          compressing lobes into single bins. Call once per frame.
+     *  @retval  - Gated magnitudes of the getNumBins() bins, valid until the
+     *             next call.
      */
-    std::pair<double, double> calcFundamentalFreq() const;
+    virtual const float *getCleanSpectrum() = 0;
 
     /**
-     *  @brief  Determines the harmonic partials present in the current FFT
-     * data.
-     *  @param  numPartials - Number of partials to retrieve.
-     *  @param  noteFreq    - Frequencies of MIDI note values, indexed by the
-     * note value.
-     *  @retval             - Pairs of frequency and amplitude for each of the
-     *                        partials.
+     *  @brief  Builds the peak table of the frame from the spectrum gated by
+     *          getCleanSpectrum(), with the peaks on the harmonics of a note
+     *          numbered. Call once per frame, after getCleanSpectrum().
+     *  @param  fundamental  - Frequency of the analysed note, 0 for none.
+     *  @param  numHarmonics - Highest harmonic to number.
+     *  @retval              - Peaks of the frame, valid until the next call.
      */
-    std::vector<std::pair<int, double>>
-    getHarmonics(const unsigned int &numPartials,
-                 const std::vector<double> &noteFreq) const;
+    virtual const PeakTable &findPeaks(double fundamental,
+                                       int numHarmonics) = 0;
+
+    const PeakTable &getPeaks() const { return peaks_; }
 
     /**
-     *  @brief Zeroes out all bins below a threshold. Lobes in the frequency
-     *         spectrum are compressed into single bins.
-     *  @param data - Bins of the FFT data.
+     *  @brief  Noise floor the frame was gated with at a frequency, in the
+     *          unit of Salience::getHarmonicMagnitude() divided by the FFT
+     *          size. Call after getCleanSpectrum().
      */
-    static void cleanUpBins(std::array<float, fftSize * 2> &data);
+    virtual double getNoiseAmplitude(double frequency) const = 0;
 
     /**
-     *  @brief  Maps all bins to the closest frequency corresponding to a note
-     *          value to be able to determine harmonical relationships.
-     *  @param  noteFreq - Sorted vector of note frequencies with their index
-     *                     corresponding to the MIDI note value.
-     *  @param  data     - Bins of the FFT data.
-     *  @retval          - Amplitudes for all MIDI note values.
+     *  @brief  Measures how much the spectrum of the frame has changed since
+     *          the reference kept by keepAsReference(), apart from its level.
+     *  @param  gain - Set to the level of the frame relative to the
+     *                 reference.
+     *  @retval      - Summed magnitude difference to the reference scaled by
+     *                 gain, as a share of the frame's summed magnitude. 1 or
+     *                 more when there is no reference.
      */
-    std::vector<double>
-    mapBinsToNotes(const std::vector<double> &noteFreq,
-                   const std::array<float, fftSize * 2UL> &data) const;
+    virtual float measureChange(float &gain) const = 0;
 
     /**
-     *  @brief  Finds the note values with largest amplitudes, determining them
-     * as harmonics of the signal.
-     *  @param  numPartials - Number of partials to retrieve in the harmonic
-     *                        spectrum.
-     *  @param  amps        - Amplitudes for all MIDI note values.
-     *  @retval             - Frequencies and amplitudes of the partials found,
-     *                        sorted by frequencies in ascending order.
+     *  @brief Keeps the magnitudes of the frame as the reference for
+     *         measureChange().
      */
-    std::vector<std::pair<int, double>> static determineHarmonics(
-        const unsigned int &numPartials, std::vector<double> &amps);
+    virtual void keepAsReference() = 0;
 
-private:
-    std::array<float, fftSize * 2UL> fftData_{0};
-    std::array<float, fftSize> fifo_{0}; /// Next block to be loaded into FFT.
-    int fifoIndex_ = 0;                  /// Iterator for FIFO.
+    /**
+     *  @brief  Refines the frequency of a note beyond the bin resolution. The
+     *          peak nearest each harmonic is located by parabolic
+     *          interpolation of the log magnitudes, and the fundamentals they
+     *          imply are averaged, weighted by amplitude and harmonic number.
+     *  @param  nominal      - Frequency of the note to refine.
+     *  @param  numHarmonics - Number of harmonics to consider.
+     *  @retval              - Estimated fundamental frequency, or nominal if no
+     *                         peak was found near any harmonic.
+     */
+    double estimateFrequency(const double &nominal,
+                             const unsigned int &numHarmonics) const;
+
+protected:
+    /**
+     *  @brief ForwardFFT object constructor
+     *  @param order           - Base 2 logarithm of the FFT size.
+     *  @param sampleRate      - Audio sample rate to use for the FFT.
+     *  @param windowingMethod - Windowing method to use for the FFT.
+     */
+    ForwardFFT(
+        int order, double sampleRate,
+        juce::dsp::WindowingFunction<float>::WindowingMethod windowingMethod);
 
+    const int fftSize_;
     const double sampleRate_;
 
-    juce::dsp::FFT forwardFFT_;
-    juce::dsp::WindowingFunction<float> window_;
-    juce::dsp::WindowingFunction<float>::WindowingMethod winMethod_;
+    /// Signals whether the FIFO has been copied into the FFT array.
+    bool nextFFTBlockReady_ = false;
+    bool analysisEnabled_{true};
+
+    PeakTable peaks_; /// Peaks of the gated magnitudes.
+    SlidingDft sliding_;
 
-    float windowCompensation_; /// Factor to compensate windowed FFT amplitudes
-                               /// with.
+    Telemetry *telemetry_{nullptr};
+
+    juce::dsp::WindowingFunction<float>::WindowingMethod winMethod_;
 
     /// Mappings of windowing methods to amplitude compensation factor.
     const std::map<juce::dsp::WindowingFunction<float>::WindowingMethod, float>
@@ -143,15 +231,127 @@ private:
 };
 
 /**
- *  @brief  Estimates a frequency's closest approximation among a set of
- *          frequencies. By passing frequencies corresponding to the 127 MIDI
- *          notes, the function returns the nearest MIDI note value.
- *  @param  target          - Frequency to estimate.
- *  @param  noteFrequencies - Frequencies to search among.
- *  @retval                 - Index of note in vector closest to target
- *                            frequency.
+ *
+ *  @class   SizedForwardFFT
+ *  @brief   ForwardFFT for a size fixed at compile time, so the FIFO, window
+ *           and bin loops have constant bounds the compiler can unroll and
+ *           vectorise. Instantiated for orders minOrder to maxOrder in
+ *           ForwardFFT.cpp.
+ *
+ */
+template <int Order> class SizedForwardFFT final : public ForwardFFT {
+private:
+    /// 2 to the power of FFT order.
+    static constexpr std::size_t fftSize = std::size_t{1} << Order;
+    /// Bins up to half the FFT size, the rest mirror them.
+    static constexpr std::size_t numBins = fftSize / 2 + 1;
+
+public:
+    /// Magnitudes of the unique bins of a frame.
+    using Spectrum = std::array<float, numBins>;
+
+    SizedForwardFFT(
+        double sampleRate,
+        juce::dsp::WindowingFunction<float>::WindowingMethod windowingMethod);
+
+    const float *getMagnitudes() const override { return magnitudes_.data(); }
+
+    void setFrameLength(int numSamples) override;
+
+    int getFrameLength() const override { return frameLength_; }
+
+    juce::String getBackendName() const override {
+        return forwardFFT_->getName();
+    }
+
+    void setWindowingFunction(const int &id) override;
+
+    int pushSamples(const float *samples, int numSamples) override;
+
+    const float *getCleanSpectrum() override;
+
+    const PeakTable &findPeaks(double fundamental, int numHarmonics) override;
+
+    double getNoiseAmplitude(double frequency) const override;
+
+    float measureChange(float &gain) const override;
+
+    void keepAsReference() override { reference_ = magnitudes_; }
+
+private:
+    /// Input and output of the transform. Only the first half is filled with
+    /// samples, the rest is working space for the complex result.
+    std::array<float, fftSize * 2UL> fftData_{0};
+    Spectrum magnitudes_{0};             /// Compensated magnitudes.
+    Spectrum cleaned_{0};                /// Magnitudes after noise gating.
+    Spectrum reference_{0};              /// Magnitudes of the kept frame.
+    std::array<float, fftSize> fifo_{0}; /// Latest samples, circular.
+    int fifoIndex_ = 0;                  /// Oldest sample, overwritten next.
+    int frameLength_{fftSize};
+    int frameLengthIndex_{0}; /// Halvings of the FFT size to frameLength_.
+    int samplesSinceFrame_{0};
+    /// Noise floor the last frame was gated with.
+    const float *frameFloors_{nullptr};
+    /// Noise floor scaled for a shortened frame.
+    Spectrum scaledFloors_{0};
+
+    /// Bins must exceed the noise floor by this factor to pass the gate.
+    static constexpr float gateRatio{4.0F};
+    /// Lowest gate threshold, for clean input with hardly any noise.
+    static constexpr float minThreshold{1.0F};
+
+    NoiseFloor noiseFloor_;
+
+    /// Fastest transform for this CPU and FFT size.
+    std::unique_ptr<FFTBackend> forwardFFT_;
+
+    /// Window multiplied by the factor that compensates windowed FFT
+    /// amplitudes, so both are applied in a single pass. One for every frame
+    /// length, compensated to the amplitudes of a full frame.
+    std::array<std::array<float, fftSize>, numFrameLengths> windowTables_{};
+    /// Uncompensated window, so changing window does not allocate on the
+    /// audio thread.
+    std::array<float, fftSize + 1> windowScratch_{0};
+
+    /**
+     *  @brief Fills the FIFO with samples and initiates FFT on the sample when
+     *         the FIFO is full.
+     *  @param sample - The sample to be stored in the FIFO.
+     */
+    void pushNextSampleIntoFifo(float sample);
+
+    /**
+     *  @brief Zeroes out all bins that do not stand out from the noise floor.
+     *         Lobes in the frequency spectrum are compressed into single bins.
+     *  @param data   - Bins of the FFT data.
+     *  @param floors - Noise floor of every bin.
+     */
+    static void cleanUpBins(Spectrum &data, const float *floors);
+
+    /**
+     *  @brief Fills the compensated window tables for a windowing method.
+     */
+    void fillWindowTable(
+        juce::dsp::WindowingFunction<float>::WindowingMethod method);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SizedForwardFFT)
+};
+
+extern template class SizedForwardFFT<9>;
+extern template class SizedForwardFFT<10>;
+extern template class SizedForwardFFT<11>;
+extern template class SizedForwardFFT<12>;
+
+/**
+ *  @brief  Creates the FFT analysis compiled for an order. Must not be called
+ *          from the audio thread.
+ *  @param  order           - Base 2 logarithm of the FFT size, limited to
+ *                            ForwardFFT::minOrder to ForwardFFT::maxOrder.
+ *  @param  sampleRate      - Audio sample rate to use for the FFT.
+ *  @param  windowingMethod - Windowing method to use for the FFT.
  */
-int findNearestNote(const double &target,
-                    const std::vector<double> &noteFrequencies);
+std::unique_ptr<ForwardFFT> createForwardFFT(
+    int order, double sampleRate,
+    juce::dsp::WindowingFunction<float>::WindowingMethod windowingMethod);
 
 } // namespace anyMidi
\ No newline at end of file
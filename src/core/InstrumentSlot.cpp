@@ -0,0 +1,258 @@
+/**
+ *
+ *  @file      InstrumentSlot.cpp
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#include "InstrumentSlot.h"
+#include "../util/Globals.h"
+#include "../util/Logger.h"
+
+juce::Identifier anyMidi::getParameterId(Parameter parameter) {
+    switch (parameter) {
+    case Parameter::AttackThreshold:
+        return anyMidi::ATTACK_THRESH_ID;
+    case Parameter::ReleaseThreshold:
+        return anyMidi::RELEASE_THRESH_ID;
+    case Parameter::NumPartials:
+        return anyMidi::PARTIALS_ID;
+    case Parameter::LowCutFrequency:
+        return anyMidi::LO_CUT_ID;
+    case Parameter::Mpe:
+        return anyMidi::MPE_ID;
+    case Parameter::WindowingFunction:
+        return anyMidi::CURRENT_WIN_ID;
+    case Parameter::AdaptiveWindow:
+        return anyMidi::ADAPTIVE_WINDOW_ID;
+    case Parameter::SmoothingLag:
+        return anyMidi::SMOOTHING_LAG_ID;
+    case Parameter::IncrementalAnalysis:
+        return anyMidi::INCREMENTAL_ANALYSIS_ID;
+    case Parameter::SlidingTracking:
+        return anyMidi::SLIDING_TRACKING_ID;
+    case Parameter::NumParameters:
+        break;
+    }
+    return {};
+}
+
+anyMidi::InstrumentSlot::InstrumentSlot(const InstrumentConfig &config,
+                                        double sampleRate,
+                                        const juce::ValueTree &state)
+    : config_{config}, state_{state},
+      pipeline_{
+          std::make_unique<AnalysisPipeline>(sampleRate, config.fftOrder)},
+      targetSampleRate_{sampleRate} {
+    for (const auto &change : config_.settings) {
+        applyParameter(change);
+    }
+
+    state_.setProperty(anyMidi::INSTRUMENT_NAME_ID, config_.name, nullptr);
+    state_.setProperty(anyMidi::INPUT_CHANNEL_ID, config_.inputChannel,
+                       nullptr);
+    state_.setProperty(anyMidi::ATTACK_THRESH_ID,
+                       pipeline_->getAttackThreshold(), nullptr);
+    state_.setProperty(anyMidi::RELEASE_THRESH_ID,
+                       pipeline_->getReleaseThreshold(), nullptr);
+    state_.setProperty(anyMidi::PARTIALS_ID, pipeline_->getNumPartials(),
+                       nullptr);
+    state_.setProperty(anyMidi::LO_CUT_ID, pipeline_->getLowCutFrequency(),
+                       nullptr);
+    state_.setProperty(anyMidi::MPE_ID, pipeline_->isMpeEnabled(), nullptr);
+    state_.setProperty(anyMidi::CURRENT_WIN_ID,
+                       pipeline_->getWindowingFunction(), nullptr);
+    state_.setProperty(anyMidi::ADAPTIVE_WINDOW_ID,
+                       pipeline_->isAdaptiveWindowEnabled(), nullptr);
+    state_.setProperty(anyMidi::SMOOTHING_LAG_ID,
+                       pipeline_->getSmoothingLag(), nullptr);
+    state_.setProperty(anyMidi::INCREMENTAL_ANALYSIS_ID,
+                       pipeline_->isIncrementalAnalysisEnabled(), nullptr);
+    state_.setProperty(anyMidi::SLIDING_TRACKING_ID,
+                       pipeline_->isSlidingTrackingEnabled(), nullptr);
+}
+
+anyMidi::InstrumentSlot::~InstrumentSlot() {
+    freePendingPipeline();
+    freeRetiredPipeline();
+}
+
+void anyMidi::InstrumentSlot::setTelemetry(Telemetry *telemetry) {
+    telemetry_ = telemetry;
+    pipeline_->setTelemetry(telemetry);
+}
+
+void anyMidi::InstrumentSlot::setSpectrumPublisher(
+    SpectrumPublisher *publisher) {
+    spectrum_ = publisher;
+    pipeline_->setSpectrumPublisher(publisher);
+}
+
+void anyMidi::InstrumentSlot::openMidiOutput() {
+    if (config_.midiOutput.isEmpty()) {
+        // ALSA sequencer and CoreMIDI ports can be created by the app itself,
+        // making a loopback driver between anyMidi and the DAW unnecessary.
+        ownOutput_ = juce::MidiOutput::createNewDevice(config_.name);
+        if (ownOutput_ != nullptr) {
+            anyMidi::log(LogLevel::Info, "Created virtual MIDI output {}",
+                         config_.name.toRawUTF8());
+        }
+        return;
+    }
+
+    for (const auto &device : juce::MidiOutput::getAvailableDevices()) {
+        if (device.name == config_.midiOutput) {
+            ownOutput_ = juce::MidiOutput::openDevice(device.identifier);
+            break;
+        }
+    }
+    if (ownOutput_ == nullptr) {
+        anyMidi::log(LogLevel::Error, "{}: failed to open MIDI output {}",
+                     config_.name.toRawUTF8(),
+                     config_.midiOutput.toRawUTF8());
+    }
+}
+
+void anyMidi::InstrumentSlot::prepare(int samplesPerBlockExpected,
+                                      double sampleRate,
+                                      juce::MidiOutput *selectedOutput,
+                                      juce::ThreadPool &builder) {
+    sampleRate_ = sampleRate;
+    buffer_.setSize(1, samplesPerBlockExpected, false, true);
+
+    // An output named in the configuration wins over the device setup's.
+    auto *midiOutput = ownOutput_.get();
+    if (config_.midiOutput.isEmpty() && selectedOutput != nullptr) {
+        midiOutput = selectedOutput;
+    }
+    pipeline_->setMidiOutput(midiOutput);
+    pipeline_->prepare(sampleRate);
+
+    // Bin frequencies and MIDI timing are fixed when a pipeline is built, so
+    // another rate needs a new one. It is built in the background, as building
+    // here would hold up the device restart.
+    freeRetiredPipeline();
+    if (sampleRate == targetSampleRate_) {
+        return;
+    }
+
+    targetSampleRate_ = sampleRate;
+    anyMidi::log(LogLevel::Info, "{}: rebuilding pipeline for {} Hz",
+                 config_.name.toRawUTF8(), sampleRate);
+
+    builder.addJob([this, sampleRate, midiOutput] {
+        auto pipeline =
+            std::make_unique<AnalysisPipeline>(sampleRate, config_.fftOrder);
+        pipeline->setTelemetry(telemetry_);
+        pipeline->setSpectrumPublisher(spectrum_);
+        pipeline->setMidiOutput(midiOutput);
+
+        // A pipeline for an earlier rate the audio thread has not taken yet
+        // is outdated.
+        delete pendingPipeline_.exchange(pipeline.release(),
+                                         std::memory_order_acq_rel);
+    });
+}
+
+void anyMidi::InstrumentSlot::applyParameter(const ParameterChange &change) {
+    if (change.parameter < Parameter::NumParameters) {
+        const auto index = static_cast<std::size_t>(change.parameter);
+        parameterValues_[index] = change.value;
+        parameterApplied_[index] = true;
+    }
+
+    switch (change.parameter) {
+    case Parameter::AttackThreshold:
+        pipeline_->setAttackThreshold(change.value);
+        break;
+    case Parameter::ReleaseThreshold:
+        pipeline_->setReleaseThreshold(change.value);
+        break;
+    case Parameter::NumPartials:
+        pipeline_->setNumPartials(static_cast<int>(change.value));
+        break;
+    case Parameter::LowCutFrequency:
+        pipeline_->setLowCutFrequency(change.value);
+        break;
+    case Parameter::Mpe:
+        pipeline_->setMpeEnabled(change.value != 0.0);
+        break;
+    case Parameter::WindowingFunction:
+        pipeline_->setWindowingFunction(static_cast<int>(change.value));
+        break;
+    case Parameter::AdaptiveWindow:
+        pipeline_->setAdaptiveWindow(change.value != 0.0);
+        break;
+    case Parameter::SmoothingLag:
+        pipeline_->setSmoothingLag(static_cast<int>(change.value));
+        break;
+    case Parameter::IncrementalAnalysis:
+        pipeline_->setIncrementalAnalysis(change.value != 0.0);
+        break;
+    case Parameter::SlidingTracking:
+        pipeline_->setSlidingTracking(change.value != 0.0);
+        break;
+    case Parameter::NumParameters:
+        break;
+    }
+}
+
+void anyMidi::InstrumentSlot::installPendingPipeline() noexcept {
+    // The previous pipeline has to be freed before the next can take over.
+    if (retiredPipeline_.load(std::memory_order_acquire) != nullptr) {
+        return;
+    }
+
+    auto *pipeline =
+        pendingPipeline_.exchange(nullptr, std::memory_order_acq_rel);
+    if (pipeline == nullptr) {
+        return;
+    }
+
+    // The new pipeline knows nothing of the notes the old one left sounding.
+    // Note offs the old one could not send go out with the new one's first
+    // block.
+    pipeline_->release();
+    pipeline->takePendingEvents(*pipeline_);
+    retiredPipeline_.store(pipeline_.release(), std::memory_order_release);
+    pipeline_.reset(pipeline);
+
+    for (std::size_t i = 0; i < numParameters; ++i) {
+        if (parameterApplied_[i]) {
+            applyParameter({static_cast<Parameter>(i), parameterValues_[i]});
+        }
+    }
+}
+
+float *anyMidi::InstrumentSlot::loadInput(const float *input,
+                                         int numSamples) noexcept {
+    auto *samples = buffer_.getWritePointer(0);
+    if (input != nullptr) {
+        juce::FloatVectorOperations::copy(samples, input, numSamples);
+    } else {
+        juce::FloatVectorOperations::clear(samples, numSamples);
+    }
+    return samples;
+}
+
+void anyMidi::InstrumentSlot::analyse(int numSamples,
+                                      juce::MidiBuffer *collector) {
+    if (!isPipelineReady()) {
+        return;
+    }
+    pipeline_->analyseBlock(buffer_.getReadPointer(0), numSamples, collector);
+}
+
+bool anyMidi::InstrumentSlot::isRebuilding() const {
+    return pendingPipeline_.load(std::memory_order_acquire) != nullptr;
+}
+
+void anyMidi::InstrumentSlot::freeRetiredPipeline() {
+    delete retiredPipeline_.exchange(nullptr, std::memory_order_acq_rel);
+}
+
+void anyMidi::InstrumentSlot::freePendingPipeline() {
+    delete pendingPipeline_.exchange(nullptr, std::memory_order_acq_rel);
+}
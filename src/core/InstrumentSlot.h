@@ -0,0 +1,223 @@
+/**
+ *
+ *  @file      InstrumentSlot.h
+ *  @brief     One instrument of a session, with its own input and pipeline.
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_audio_devices/juce_audio_devices.h>
+#include <juce_core/juce_core.h>
+#include <juce_data_structures/juce_data_structures.h>
+
+#include "AnalysisPipeline.h"
+#include "Capture.h"
+
+namespace anyMidi {
+
+/**
+ *
+ *  @struct  InstrumentConfig
+ *  @brief   Settings of an instrument, as loaded from a session file.
+ *
+ */
+struct InstrumentConfig {
+    juce::String name;
+    int inputChannel{0}; /// Index among the device's active inputs.
+    /// MIDI output device to open by name. If empty, a virtual port named
+    /// after the instrument is created where the platform supports it.
+    juce::String midiOutput;
+    /// Base 2 logarithm of the pipeline's FFT size.
+    int fftOrder{ForwardFFT::defaultOrder};
+    /// Applied over the pipeline defaults.
+    std::vector<ParameterChange> settings;
+};
+
+/**
+ *  @brief  ValueTree property holding a parameter, both in the GUI node and
+ *          in instrument nodes.
+ */
+juce::Identifier getParameterId(Parameter parameter);
+
+/**
+ *
+ *  @class   InstrumentSlot
+ *  @brief   Runs one input channel through its own analysis pipeline into
+ *           its own MIDI output. The pipeline is rebuilt in the background
+ *           when the device's sample rate changes and swapped in by the
+ *           audio thread, which never allocates or frees. The slot's
+ *           settings live in its ValueTree node, keyed like the GUI's.
+ *
+ */
+class InstrumentSlot {
+public:
+    /**
+     *  @brief InstrumentSlot object constructor.
+     *  @param config     - Name, input, output and settings.
+     *  @param sampleRate - Rate to build the first pipeline for.
+     *  @param state      - Node the settings are written to.
+     */
+    InstrumentSlot(const InstrumentConfig &config, double sampleRate,
+                   const juce::ValueTree &state);
+
+    /**
+     *  @brief InstrumentSlot object destructor. The builder must have no jobs
+     *         for the slot left.
+     */
+    ~InstrumentSlot();
+
+    const InstrumentConfig &getConfig() const { return config_; }
+
+    const juce::String &getName() const { return config_.name; }
+
+    int getInputChannel() const { return config_.inputChannel; }
+
+    juce::ValueTree &getState() { return state_; }
+
+    /**
+     *  @brief Pipeline currently run by the audio thread. Message thread
+     *         only while the device is stopped.
+     */
+    AnalysisPipeline &getPipeline() { return *pipeline_; }
+
+    /**
+     *  @brief Sets where stage timings and spectra go, for this and rebuilt
+     *         pipelines. Null disables them.
+     */
+    void setTelemetry(Telemetry *telemetry);
+    void setSpectrumPublisher(SpectrumPublisher *publisher);
+
+    /**
+     *  @brief Opens the MIDI output of the configuration. Message thread
+     *         only.
+     */
+    void openMidiOutput();
+
+    /**
+     *  @brief  Prepares for a new stream, starting a rebuild of the pipeline
+     *          if the sample rate changed. Message thread only, while the
+     *          device is stopped.
+     *  @param  samplesPerBlockExpected - Largest block to expect.
+     *  @param  sampleRate              - Sample rate of the stream.
+     *  @param  selectedOutput          - Output chosen in the device setup,
+     *                                    used over a virtual port. May be
+     *                                    null.
+     *  @param  builder                 - Pool the pipeline is rebuilt on.
+     */
+    void prepare(int samplesPerBlockExpected, double sampleRate,
+                 juce::MidiOutput *selectedOutput, juce::ThreadPool &builder);
+
+    /**
+     *  @brief Applies a parameter change to the pipeline, and remembers it
+     *         for rebuilt ones. Audio thread only, or before the device
+     *         starts.
+     */
+    void applyParameter(const ParameterChange &change);
+
+    /**
+     *  @brief Swaps in a rebuilt pipeline, if one is ready, turning off the
+     *         notes of the old one first. Audio thread only.
+     */
+    void installPendingPipeline() noexcept;
+
+    /**
+     *  @brief  Copies a block of the slot's input channel into the slot's
+     *          buffer, to be filtered there. Audio thread only.
+     *  @param  input      - Samples of the input channel, or null if the
+     *                       channel is not active on the device.
+     *  @param  numSamples - Number of samples in the block, at most the
+     *                       prepared block size.
+     *  @retval            - Samples in the buffer.
+     */
+    float *loadInput(const float *input, int numSamples) noexcept;
+
+    /**
+     *  @brief High-pass filter the loaded input should get before analyse().
+     */
+    const juce::IIRCoefficients &getHighPassCoefficients() const {
+        return pipeline_->getHighPassCoefficients();
+    }
+
+    /**
+     *  @brief  Analyses the filtered block in the buffer. Blocks are let
+     *          through unanalysed until a pipeline for the stream's rate is
+     *          ready, rather than giving wrong notes. Audio thread only.
+     *  @param  numSamples - Number of samples in the block.
+     *  @param  collector  - Optional buffer for the block's MIDI events.
+     */
+    void analyse(int numSamples, juce::MidiBuffer *collector);
+
+    /**
+     *  @brief  Whether the pipeline is built for the stream's rate, so that
+     *          analyse() analyses.
+     */
+    bool isPipelineReady() const {
+        return pipeline_->getAnalysisSampleRate() == sampleRate_;
+    }
+
+    /**
+     *  @brief Turns off sounding notes.
+     */
+    void release() { pipeline_->release(); }
+
+    /**
+     *  @brief  Whether a rebuilt pipeline is still on its way to the audio
+     *          thread.
+     */
+    bool isRebuilding() const;
+
+    /**
+     *  @brief Frees the pipeline last replaced by the audio thread. Message
+     *         thread only.
+     */
+    void freeRetiredPipeline();
+
+    /**
+     *  @brief Frees the pipelines not yet taken by the audio thread, once the
+     *         builder has finished. Message thread only.
+     */
+    void freePendingPipeline();
+
+private:
+    static constexpr auto numParameters{
+        static_cast<std::size_t>(Parameter::NumParameters)};
+
+    const InstrumentConfig config_;
+    juce::ValueTree state_;
+
+    /// Pipeline run by the audio thread.
+    std::unique_ptr<AnalysisPipeline> pipeline_;
+    /// Built in the background, waiting for the audio thread to take it.
+    std::atomic<AnalysisPipeline *> pendingPipeline_{nullptr};
+    /// Replaced by the audio thread, waiting to be freed off it.
+    std::atomic<AnalysisPipeline *> retiredPipeline_{nullptr};
+    /// Rate of the newest pipeline, built or being built.
+    double targetSampleRate_;
+    double sampleRate_{0.0};
+
+    /// Values applied so far, reapplied to a rebuilt pipeline.
+    std::array<double, numParameters> parameterValues_{};
+    std::array<bool, numParameters> parameterApplied_{};
+
+    /// Output opened for the configuration, if any.
+    std::unique_ptr<juce::MidiOutput> ownOutput_;
+    Telemetry *telemetry_{nullptr};
+    SpectrumPublisher *spectrum_{nullptr};
+
+    /// Copy of the input, filtered in place.
+    juce::AudioSampleBuffer buffer_;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(InstrumentSlot)
+};
+
+} // namespace anyMidi
@@ -0,0 +1,255 @@
+/**
+ *
+ *  @file      MappedAudioSource.cpp
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+
+#include "AnalysisPipeline.h"
+#include "MappedAudioSource.h"
+
+namespace {
+constexpr int pcmFormat{1};
+constexpr int floatFormat{3};
+constexpr int extensibleFormat{0xFFFE};
+
+juce::uint32 chunkId(const char *id) {
+    return juce::ByteOrder::littleEndianInt(id);
+}
+
+/**
+ *  @brief Converts interleaved little endian samples of one channel to float.
+ */
+template <typename SourceFormat>
+void convert(const char *source, int numChannels, float *dest,
+             int numSamples) {
+    using Source =
+        juce::AudioData::Pointer<SourceFormat, juce::AudioData::LittleEndian,
+                                 juce::AudioData::Interleaved,
+                                 juce::AudioData::Const>;
+    using Dest =
+        juce::AudioData::Pointer<juce::AudioData::Float32,
+                                 juce::AudioData::NativeEndian,
+                                 juce::AudioData::NonInterleaved,
+                                 juce::AudioData::NonConst>;
+
+    Dest{dest}.convertSamples(Source{source, numChannels}, numSamples);
+}
+} // namespace
+
+anyMidi::MappedAudioSource::MappedAudioSource(const juce::File &file)
+    : file_{file} {
+    parseHeader();
+}
+
+void anyMidi::MappedAudioSource::parseHeader() {
+    juce::FileInputStream in{file_};
+    if (in.failedToOpen() ||
+        static_cast<juce::uint32>(in.readInt()) != chunkId("RIFF")) {
+        return;
+    }
+    in.readInt(); // RIFF size, unreliable for files still being written.
+    if (static_cast<juce::uint32>(in.readInt()) != chunkId("WAVE")) {
+        return;
+    }
+
+    int formatCode{0};
+    int bitsPerSample{0};
+    juce::int64 dataBytes{-1};
+
+    while (!in.isExhausted()) {
+        const auto id = static_cast<juce::uint32>(in.readInt());
+        const auto size = static_cast<juce::uint32>(in.readInt());
+        const auto chunkStart = in.getPosition();
+
+        if (id == chunkId("fmt ")) {
+            formatCode = static_cast<juce::uint16>(in.readShort());
+            numChannels_ = in.readShort();
+            sampleRate_ = static_cast<juce::uint32>(in.readInt());
+            in.readInt(); // Bytes per second.
+            bytesPerFrame_ = in.readShort();
+            bitsPerSample = in.readShort();
+
+            constexpr juce::uint32 extensibleSize{40};
+            if (formatCode == extensibleFormat && size >= extensibleSize) {
+                // Size, valid bits and channel mask precede the sub format,
+                // whose first two bytes are the format code.
+                in.readShort();
+                in.readShort();
+                in.readInt();
+                formatCode = static_cast<juce::uint16>(in.readShort());
+            }
+        } else if (id == chunkId("data")) {
+            dataStart_ = chunkStart;
+            dataBytes = size;
+            break;
+        }
+
+        // Chunks are padded to an even size.
+        in.setPosition(chunkStart + size + (size & 1U));
+    }
+
+    if (dataBytes < 0 || numChannels_ <= 0 || bitsPerSample <= 0 ||
+        bytesPerFrame_ != numChannels_ * bitsPerSample / 8) {
+        return;
+    }
+
+    if (formatCode == pcmFormat && bitsPerSample == 16) {
+        format_ = SampleFormat::Int16;
+    } else if (formatCode == pcmFormat && bitsPerSample == 24) {
+        format_ = SampleFormat::Int24;
+    } else if (formatCode == pcmFormat && bitsPerSample == 32) {
+        format_ = SampleFormat::Int32;
+    } else if (formatCode == floatFormat && bitsPerSample == 32) {
+        format_ = SampleFormat::Float32;
+    } else {
+        return;
+    }
+
+    // Trusts the file size over the chunk size, which a recorder that was
+    // interrupted may have left unwritten.
+    numFrames_ = std::min(dataBytes, file_.getSize() - dataStart_) /
+                 bytesPerFrame_;
+}
+
+const char *anyMidi::MappedAudioSource::getMapped(juce::int64 offset,
+                                                  juce::int64 numBytes) {
+    const juce::Range<juce::int64> needed{offset, offset + numBytes};
+
+    if (map_ == nullptr || !map_->getRange().contains(needed)) {
+        // Unmaps the previous window first, releasing its pages.
+        map_ = nullptr;
+
+        // JUCE maps with sequential read-ahead advice where the platform
+        // supports it, so the kernel prefetches ahead of the reads and
+        // drops pages behind them.
+        const auto dataEnd = dataStart_ + numFrames_ * bytesPerFrame_;
+        map_ = std::make_unique<juce::MemoryMappedFile>(
+            file_,
+            juce::Range<juce::int64>{
+                offset, std::min(dataEnd, offset + std::max(windowBytes,
+                                                            numBytes))},
+            juce::MemoryMappedFile::readOnly);
+
+        if (map_->getData() == nullptr) {
+            map_ = nullptr;
+            return nullptr;
+        }
+    }
+
+    return static_cast<const char *>(map_->getData()) +
+           (offset - map_->getRange().getStart());
+}
+
+int anyMidi::MappedAudioSource::read(float *dest, int maxSamples) {
+    const auto numSamples = static_cast<int>(
+        std::min(static_cast<juce::int64>(maxSamples), numFrames_ - position_));
+    if (!isValid() || numSamples <= 0) {
+        return 0;
+    }
+
+    const char *source =
+        getMapped(dataStart_ + position_ * bytesPerFrame_,
+                  static_cast<juce::int64>(numSamples) * bytesPerFrame_);
+    if (source == nullptr) {
+        return 0;
+    }
+
+    switch (format_) {
+    case SampleFormat::Int16:
+        convert<juce::AudioData::Int16>(source, numChannels_, dest,
+                                        numSamples);
+        break;
+    case SampleFormat::Int24:
+        convert<juce::AudioData::Int24>(source, numChannels_, dest,
+                                        numSamples);
+        break;
+    case SampleFormat::Int32:
+        convert<juce::AudioData::Int32>(source, numChannels_, dest,
+                                        numSamples);
+        break;
+    case SampleFormat::Float32:
+        convert<juce::AudioData::Float32>(source, numChannels_, dest,
+                                          numSamples);
+        break;
+    case SampleFormat::Unsupported:
+        return 0;
+    }
+
+    position_ += numSamples;
+    return numSamples;
+}
+
+bool anyMidi::runTranscription(const juce::File &input,
+                               const juce::File &output) {
+    MappedAudioSource source{input};
+    if (!source.isValid()) {
+        std::cout << "Unsupported or unreadable WAV file: "
+                  << input.getFullPathName() << "\n";
+        return false;
+    }
+
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+    const double sampleRate = source.getSampleRate();
+    constexpr int blockSize{256};
+    constexpr double msPerSecond{1000.0};
+
+    AnalysisPipeline pipeline{sampleRate};
+    pipeline.prepare(sampleRate);
+
+    std::array<float, MappedAudioSource::chunkSize> chunk{};
+    juce::MidiBuffer events;
+    juce::MidiMessageSequence sequence;
+
+    int numRead{0};
+    juce::int64 blockStart{0};
+    while ((numRead = source.read(chunk.data(),
+                                  static_cast<int>(chunk.size()))) > 0) {
+        for (int start = 0; start < numRead; start += blockSize) {
+            const int numSamples = std::min(blockSize, numRead - start);
+            pipeline.processBlock(chunk.data() + start, numSamples, &events);
+
+            // Events come placed by offset into their block, and are emptied
+            // every block, so the buffer stays small however long the
+            // recording is.
+            for (const auto metadata : events) {
+                auto message = metadata.getMessage();
+                message.setTimeStamp(
+                    static_cast<double>(blockStart + metadata.samplePosition) *
+                    msPerSecond / sampleRate);
+                sequence.addEvent(message);
+            }
+            events.clear();
+            blockStart += numSamples;
+        }
+    }
+    sequence.updateMatchedPairs();
+
+    // 25 frames of 40 ticks per second, so ticks are milliseconds.
+    constexpr int framesPerSecond{25};
+    constexpr int ticksPerFrame{40};
+    juce::MidiFile midiFile;
+    midiFile.setSmpteTimeFormat(framesPerSecond, ticksPerFrame);
+    midiFile.addTrack(sequence);
+
+    output.deleteFile();
+    juce::FileOutputStream stream{output};
+    if (stream.failedToOpen() || !midiFile.writeTo(stream)) {
+        std::cout << "Failed to write " << output.getFullPathName() << "\n";
+        return false;
+    }
+
+    const double elapsed = juce::Time::highResolutionTicksToSeconds(
+        juce::Time::getHighResolutionTicks() - startTicks);
+    std::cout << sequence.getNumEvents() << " MIDI events from "
+              << static_cast<double>(source.getLengthInSamples()) / sampleRate
+              << " s of audio written to " << output.getFullPathName()
+              << " in " << elapsed << " s\n";
+    return true;
+}
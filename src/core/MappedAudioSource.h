@@ -0,0 +1,96 @@
+/**
+ *
+ *  @file      MappedAudioSource.h
+ *  @brief     Memory mapped reading of long recordings for offline analysis.
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+namespace anyMidi {
+
+/**
+ *
+ *  @class   MappedAudioSource
+ *  @brief   Streams the first channel of an uncompressed WAV file as float
+ *           samples without loading the file. Only a window of the file is
+ *           mapped at a time, so memory use does not grow with its length.
+ *           Samples are converted straight from the mapping into the
+ *           caller's buffer, which should be small enough to stay in cache.
+ *
+ */
+class MappedAudioSource {
+public:
+    /// Block converted per read by the offline tools, 16 KiB of floats.
+    static constexpr int chunkSize{4096};
+
+    explicit MappedAudioSource(const juce::File &file);
+
+    /**
+     *  @brief  Whether the file is a WAV file in a supported format: 16, 24
+     *          or 32 bit integer PCM, or 32 bit float.
+     */
+    bool isValid() const { return format_ != SampleFormat::Unsupported; }
+
+    double getSampleRate() const { return sampleRate_; }
+
+    juce::int64 getLengthInSamples() const { return numFrames_; }
+
+    juce::int64 getPosition() const { return position_; }
+
+    /**
+     *  @brief  Converts the next samples of the first channel to float.
+     *  @param  dest       - Destination of the samples.
+     *  @param  maxSamples - Most samples to read.
+     *  @retval            - Number of samples read, 0 at the end of the file.
+     */
+    int read(float *dest, int maxSamples);
+
+private:
+    enum class SampleFormat { Unsupported, Int16, Int24, Int32, Float32 };
+
+    /// Bytes of the file mapped at a time.
+    static constexpr juce::int64 windowBytes{16 * 1024 * 1024};
+
+    /**
+     *  @brief  Finds the format and data chunks of the file.
+     */
+    void parseHeader();
+
+    /**
+     *  @brief  Pointer to a range of the file, moving the mapped window
+     *          forward when the range is outside it.
+     *  @retval  - Null if the range could not be mapped.
+     */
+    const char *getMapped(juce::int64 offset, juce::int64 numBytes);
+
+    const juce::File file_;
+    std::unique_ptr<juce::MemoryMappedFile> map_;
+
+    SampleFormat format_{SampleFormat::Unsupported};
+    int numChannels_{0};
+    int bytesPerFrame_{0};
+    double sampleRate_{0.0};
+    juce::int64 dataStart_{0}; /// Byte offset of the first sample.
+    juce::int64 numFrames_{0};
+    juce::int64 position_{0}; /// Next frame to read.
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MappedAudioSource)
+};
+
+/**
+ *  @brief  Transcribes a WAV recording offline into a MIDI file, timed in
+ *          milliseconds.
+ *  @param  input  - WAV file to transcribe.
+ *  @param  output - MIDI file to write, replaced if it exists.
+ *  @retval        - False if the input could not be read or the output could
+ *                   not be written.
+ */
+bool runTranscription(const juce::File &input, const juce::File &output);
+
+} // namespace anyMidi
@@ -9,93 +9,96 @@
 
 #include "MidiProcessor.h"
 
-anyMidi::MidiProcessor::MidiProcessor(const unsigned int &sampleRate,
-                                      const double &startTime)
-    : sampleRate_{sampleRate}, startTime_{startTime} {}
+anyMidi::MidiProcessor::MidiProcessor(const unsigned int &sampleRate)
+    : sampleRate_{sampleRate},
+      setLowerZone_{juce::MPEMessages::setLowerZone(numMpeMemberChannels,
+                                                    mpePitchBendRange)},
+      clearLowerZone_{juce::MPEMessages::clearLowerZone()} {
+    midiBuffer_.ensureSize(bufferCapacity);
+    pending_.reserve(pendingCapacity);
+}
 
 void anyMidi::MidiProcessor::setMidiOutput(juce::MidiOutput *output) {
     midiOut_ = output;
+
+    // A new receiver has to learn the zone layout.
+    if (mpeEnabled_) {
+        midiBuffer_.addEvents(setLowerZone_, 0, -1, getBlockOffset());
+    }
+}
+
+void anyMidi::MidiProcessor::setMpeEnabled(const bool enabled) {
+    if (enabled == mpeEnabled_) {
+        return;
+    }
+    mpeEnabled_ = enabled;
+
+    // The sounding note keeps its channel until it is turned off.
+    midiBuffer_.addEvents(enabled ? setLowerZone_ : clearLowerZone_, 0, -1,
+                          getBlockOffset());
 }
 
 auto anyMidi::MidiProcessor::getAttackThreshold() const -> double {
-    return attackThreshold_;
+    return tracker_.getAttackThreshold();
 }
 
 auto anyMidi::MidiProcessor::getReleaseThreshold() const -> double {
-    return releaseThreshold_;
+    return tracker_.getReleaseThreshold();
 }
 
 void anyMidi::MidiProcessor::setAttackThreshold(double &t) {
-    attackThreshold_ = t;
+    tracker_.setAttackThreshold(t);
 }
 
 void anyMidi::MidiProcessor::setReleaseThreshold(double &t) {
-    releaseThreshold_ = t;
+    tracker_.setReleaseThreshold(t);
 }
 
 auto anyMidi::MidiProcessor::determineNoteValue(
-    const int &note, const double &amp,
-    std::vector<std::pair<int, bool>> &noteValues) -> bool {
-    // Ensures that notes are within midi range.
-    constexpr std::pair<int, int> kMidiRange{0, 128};
-    if (note >= kMidiRange.first && note < kMidiRange.second) {
-        // When there's no note currently playing, and the note
-        // surpasses the threshold.
-        if (!midiNoteCurrentlyOn_ && amp > attackThreshold_) {
-            noteValues.emplace_back(note, true); // Note on
-            midiNoteCurrentlyOn_ = true;
-            lastNote_ = note;
-            lastAmp_ = amp;
-            return true;
-        }
-        // When another note is currently playing.
-        if (midiNoteCurrentlyOn_) {
-            // When new note is different from the last note.
-            if (note != lastNote_) {
-                // When new, different note surpasses threshold.
-                // Last note is turned off before new note is turned on.
-                if (amp > attackThreshold_) {
-                    noteValues.emplace_back(lastNote_, false); // Note off
-                    noteValues.emplace_back(note, true);       // Note on
-                    midiNoteCurrentlyOn_ = true;
-                    lastNote_ = note;
-                    lastAmp_ = amp;
-                    return true;
-                }
-                return false;
-            }
-            // When new note is the same as last note,
-            // it has to be sufficiently louder to retrigger.
-            if (amp > lastAmp_ * 3) {
-                if (amp > attackThreshold_) {
-                    noteValues.emplace_back(lastNote_, false); // Note off
-                    noteValues.emplace_back(note, true);       // Note on
-                    midiNoteCurrentlyOn_ = true;
-                    lastNote_ = note;
-                    lastAmp_ = amp;
-                    return true;
-                }
-                return false;
-            }
-            // When new note is not different, nor louder than last
-            // it's probably a releasing note and we check if it has rung out.
-            if (amp < releaseThreshold_) {
-                noteValues.emplace_back(lastNote_, false); // Note off
-                midiNoteCurrentlyOn_ = false;
-                return true;
-            }
-            lastAmp_ = amp;
-        }
+    const int &note, const double &pitch, const double &amp,
+    NoteChanges &noteValues) -> bool {
+    lastPitch_ = pitch;
+    return tracker_.process(note, pitch, amp, samplePosition_, sampleRate_,
+                            noteValues);
+}
+
+void anyMidi::MidiProcessor::updateExpression(const double &pitch,
+                                              const double &amp) {
+    if (activeNote_ < 0) {
+        return;
+    }
+
+    const auto minInterval = static_cast<juce::int64>(
+        minExpressionInterval * static_cast<double>(sampleRate_));
+
+    // Pitch far from the sounding note belongs to something else.
+    const double bend = pitch - tracker_.getActiveNote();
+    if (std::abs(bend) <= NoteTracker::maxBend &&
+        std::abs(bend - lastSentBend_) >= bendDeadband &&
+        samplePosition_ - lastBendSample_ >= minInterval) {
+        addMessageNow(createPitchBend(bend));
+        lastSentBend_ = bend;
+        lastBendSample_ = samplePosition_;
+    }
+
+    constexpr int maxPressure{127};
+    const int pressure =
+        juce::jlimit(0, maxPressure, juce::roundToInt(amp * maxPressure));
+    if (std::abs(pressure - lastSentPressure_) >= pressureDeadband &&
+        samplePosition_ - lastPressureSample_ >= minInterval) {
+        addMessageNow(
+            juce::MidiMessage::channelPressureChange(activeChannel_, pressure));
+        lastSentPressure_ = pressure;
+        lastPressureSample_ = samplePosition_;
     }
-    return false;
 }
 
 void anyMidi::MidiProcessor::createMidiMsg(const int &noteNum,
                                            const juce::uint8 &velocity,
                                            const bool noteOn) {
-    juce::MidiMessage midiMessage;
-
-    // JUCE is one octave off for some reason.
+    // Analysed notes are an octave low, as ForwardFFT::getBinWidth() spaces
+    // the bins for twice the FFT size. This shifts them back to the played
+    // pitch.
     constexpr int juceOctaveOffset = 12;
     const int scaledNoteNum = noteNum + juceOctaveOffset;
     // Bounds represent note range of a typical guitar
@@ -103,26 +106,62 @@ void anyMidi::MidiProcessor::createMidiMsg(const int &noteNum,
     constexpr int noteUpperBound{90};
     if (scaledNoteNum >= noteLowerBound && scaledNoteNum < noteUpperBound) {
         if (noteOn) {
-            midiMessage = juce::MidiMessage::noteOn(midiChannel, scaledNoteNum,
-                                                    velocity);
+            activeChannel_ = allocateChannel();
+
+            // Channel expression is set before the note starts, so the note
+            // begins at its tracked pitch and never inherits an old bend.
+            lastSentBend_ = lastPitch_ - noteNum;
+            addMessageNow(createPitchBend(lastSentBend_));
+            lastSentPressure_ = velocity;
+            addMessageNow(juce::MidiMessage::channelPressureChange(
+                activeChannel_, velocity));
+            lastBendSample_ = samplePosition_;
+            lastPressureSample_ = samplePosition_;
+
+            addMessageNow(juce::MidiMessage::noteOn(
+                activeChannel_, scaledNoteNum, velocity));
+            activeNote_ = scaledNoteNum;
         } else {
-            midiMessage =
-                juce::MidiMessage::noteOff(midiChannel, scaledNoteNum);
+            addMessageNow(
+                juce::MidiMessage::noteOff(activeChannel_, scaledNoteNum));
+            activeNote_ = -1;
         }
+    }
+}
 
-        constexpr double secondScale = 0.001;
-        midiMessage.setTimeStamp(
-            juce::Time::getMillisecondCounter() * secondScale - startTime_);
-        addMessageToBuffer(midiMessage);
+int anyMidi::MidiProcessor::allocateChannel() {
+    if (!mpeEnabled_) {
+        return midiChannel;
     }
+    const int channel = mpeMasterChannel + 1 + nextMemberChannel_;
+    nextMemberChannel_ = (nextMemberChannel_ + 1) % numMpeMemberChannels;
+    return channel;
+}
+
+int anyMidi::MidiProcessor::getPitchBendRange() const {
+    return mpeEnabled_ ? mpePitchBendRange : pitchBendRange;
+}
+
+juce::MidiMessage
+anyMidi::MidiProcessor::createPitchBend(const double bend) const {
+    const auto range = static_cast<float>(getPitchBendRange());
+    const auto clamped = juce::jlimit(-range, range, static_cast<float>(bend));
+    return juce::MidiMessage::pitchWheel(
+        activeChannel_,
+        juce::MidiMessage::pitchbendToPitchwheelPos(clamped, range));
+}
+
+void anyMidi::MidiProcessor::addMessageNow(juce::MidiMessage message) {
+    message.setTimeStamp(static_cast<double>(samplePosition_) / sampleRate_);
+    midiBuffer_.addEvent(message, getBlockOffset());
 }
 
 void anyMidi::MidiProcessor::addMessageToBuffer(
     const juce::MidiMessage &message) {
     const double timestamp = message.getTimeStamp();
-    const int sampleNumber = static_cast<int>(timestamp * sampleRate_);
+    const auto sampleNumber = static_cast<juce::int64>(timestamp * sampleRate_);
 
-    midiBuffer_.addEvent(message, sampleNumber);
+    midiBuffer_.addEvent(message, static_cast<int>(sampleNumber - blockStart_));
 }
 
 void anyMidi::MidiProcessor::pushBufferToOutput() {
@@ -132,12 +171,102 @@ void anyMidi::MidiProcessor::pushBufferToOutput() {
 
     if (midiOut_ != nullptr) {
         midiOut_->sendBlockOfMessagesNow(midiBuffer_);
+    }
+    midiBuffer_.clear();
+    blockStart_ = samplePosition_;
+}
+
+void anyMidi::MidiProcessor::takePendingMessages(MidiProcessor &other) {
+    midiBuffer_.addEvents(other.midiBuffer_, 0, -1, getBlockOffset());
+    other.midiBuffer_.clear();
+}
+
+void anyMidi::MidiProcessor::coalesceBuffer() {
+    const auto numEvents = static_cast<std::size_t>(midiBuffer_.getNumEvents());
+    // A larger block is sent as it is, since growing pending_ would allocate
+    // on the audio thread.
+    if (numEvents < 2 || numEvents > pendingCapacity) {
+        return;
+    }
+
+    pending_.clear();
+    for (const auto metadata : midiBuffer_) {
+        pending_.push_back(
+            {metadata.getMessage(), metadata.samplePosition, true});
+    }
+
+    bool dropped{false};
+
+    // A note turned on and off within the block was never heard.
+    for (std::size_t i = 0; i < pending_.size(); ++i) {
+        const auto &off = pending_[i].message;
+        if (!off.isNoteOff()) {
+            continue;
+        }
+        for (auto j = i; j-- > 0;) {
+            auto &on = pending_[j];
+            if (on.keep && on.message.isNoteOn() &&
+                on.message.getChannel() == off.getChannel() &&
+                on.message.getNoteNumber() == off.getNoteNumber()) {
+                on.keep = false;
+                pending_[i].keep = false;
+                dropped = true;
+                break;
+            }
+        }
+    }
+
+    // Walking backwards, a pitch bend or pressure is superseded when the
+    // same channel has a later one and no note starts in between.
+    constexpr int numChannels{16};
+    std::array<bool, numChannels + 1> laterBend{};
+    std::array<bool, numChannels + 1> laterPressure{};
+    for (auto i = pending_.size(); i-- > 0;) {
+        auto &p = pending_[i];
+        if (!p.keep) {
+            continue;
+        }
+        const auto channel = static_cast<std::size_t>(p.message.getChannel());
+        if (p.message.isNoteOn()) {
+            laterBend[channel] = false;
+            laterPressure[channel] = false;
+        } else if (p.message.isPitchWheel()) {
+            p.keep = !laterBend[channel];
+            laterBend[channel] = true;
+        } else if (p.message.isChannelPressure()) {
+            p.keep = !laterPressure[channel];
+            laterPressure[channel] = true;
+        }
+        dropped = dropped || !p.keep;
+    }
+
+    if (dropped) {
         midiBuffer_.clear();
+        for (const auto &p : pending_) {
+            if (p.keep) {
+                midiBuffer_.addEvent(p.message, p.samplePosition);
+            }
+        }
     }
 }
 
+void anyMidi::MidiProcessor::collectBuffer(juce::MidiBuffer &dest) const {
+    dest.addEvents(midiBuffer_, 0, -1, 0);
+}
+
 void anyMidi::MidiProcessor::turnOffAllMessages() {
-    if (midiOut_) {
-        midiOut_->sendMessageNow(juce::MidiMessage::allNotesOff(midiChannel));
+    addMessageNow(juce::MidiMessage::allNotesOff(midiChannel));
+
+    // Notes may be left on any member channel.
+    for (int i = 0; i < numMpeMemberChannels; ++i) {
+        addMessageNow(juce::MidiMessage::allNotesOff(mpeMasterChannel + 1 + i));
+    }
+
+    // A plugin has no output, its host takes the note offs with the next
+    // block instead.
+    if (midiOut_ != nullptr) {
+        pushBufferToOutput();
     }
+    activeNote_ = -1;
+    tracker_.reset();
 }
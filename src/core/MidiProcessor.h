@@ -12,6 +12,8 @@
 
 #include <juce_audio_devices/juce_audio_devices.h>
 
+#include "NoteTracker.h"
+
 namespace anyMidi {
 
 /**
@@ -22,7 +24,7 @@ namespace anyMidi {
  */
 class MidiProcessor {
 public:
-    MidiProcessor(const unsigned int &sampleRate, const double &startTime);
+    explicit MidiProcessor(const unsigned int &sampleRate);
 
     void setMidiOutput(juce::MidiOutput *output);
 
@@ -33,29 +35,98 @@ public:
     void setReleaseThreshold(double &t);
 
     /**
-     *  @brief Empties MIDI buffer and clears it.
+     *  @brief Note decision state, for tuning hysteresis and minimum note
+     *         durations.
+     */
+    NoteTracker &getNoteTracker() { return tracker_; }
+
+    /**
+     *  @brief Switches between MPE output, where every note gets its own
+     *         member channel in the lower zone, and single channel output.
+     *         The zone configuration is sent to the output when enabled.
+     *  @param enabled - Whether to use MPE.
+     */
+    void setMpeEnabled(bool enabled);
+
+    bool isMpeEnabled() const { return mpeEnabled_; }
+
+    /**
+     *  @brief  Number of MIDI events waiting to be sent.
+     */
+    int getNumQueuedEvents() const { return midiBuffer_.getNumEvents(); }
+
+    /**
+     *  @brief  Whether a MIDI note on has been sent without a note off.
+     */
+    bool isNoteOn() const { return tracker_.getActiveNote() >= 0; }
+
+    /**
+     *  @brief Moves the stream clock forward. Messages are timestamped by
+     *         this clock, so output is the same whether the samples arrive in
+     *         real time or offline.
+     *  @param numSamples - Number of samples processed.
+     */
+    void advance(int numSamples) { samplePosition_ += numSamples; }
+
+    /**
+     *  @brief Removes redundant messages from the pending block. Notes turned
+     *         on and off again within the block are dropped, and only the
+     *         last pitch bend and pressure of each channel before any note
+     *         on is kept.
+     */
+    void coalesceBuffer();
+
+    /**
+     *  @brief Copies the pending MIDI messages into another buffer, placed by
+     *         offset from the start of the block.
+     *  @param dest - Buffer to add the messages to.
+     */
+    void collectBuffer(juce::MidiBuffer &dest) const;
+
+    /**
+     *  @brief Sends the pending messages to the output, if there is one, and
+     *         clears them. The next block starts at the stream clock.
      */
     void pushBufferToOutput();
 
+    /**
+     *  @brief Moves the messages another processor has pending to the start
+     *         of this one's block. Real-time safe.
+     *  @param other - Processor to take the messages from.
+     */
+    void takePendingMessages(MidiProcessor &other);
+
     /**
      *  @brief Catch-all function to make sure no MIDI messages are left turned
-     *         on.
+     *         on. The note offs are sent at once if there is an output, and
+     *         otherwise left pending for the next block to collect.
      */
     void turnOffAllMessages();
 
     /**
      *  @brief  Determines if there is need for new MIDI note and decides wether
                 to add a new note, and wether to turn off the last MIDI note if
-                one is still playing.
+                one is still playing. See NoteTracker.
      *  @param  note       - Midi note value.
+     *  @param  pitch      - Tracked pitch as a fractional MIDI note value.
+     *                       Small, gradual moves away from the sounding note
+     *                       are bends and do not retrigger.
      *  @param  amp        - Amplitude of the midi note.
-     *  @param  noteValues - A return vector in which determined midi notes are
-     *                       placed.
+     *  @param  noteValues - Where determined midi notes are placed.
      *  @retval            - Flag signaling if there is need to create new midi
      *                       messages.
      */
-    bool determineNoteValue(const int &note, const double &amp,
-                            std::vector<std::pair<int, bool>> &noteValues);
+    bool determineNoteValue(const int &note, const double &pitch,
+                            const double &amp, NoteChanges &noteValues);
+
+    /**
+     *  @brief Sends pitch bend and channel pressure for the sounding note.
+     *         Values are deduplicated against the last ones sent, and not sent
+     *         more often than minExpressionInterval.
+     *  @param pitch - Tracked pitch as a fractional MIDI note value.
+     *  @param amp   - Amplitude of the note.
+     */
+    void updateExpression(const double &pitch, const double &amp);
 
     /**
      *  @brief Creates a new MIDI message and pushes it to the buffer.
@@ -73,28 +144,89 @@ public:
     void addMessageToBuffer(const juce::MidiMessage &message);
 
 private:
+    /// Pending block, reserved up front so queueing never allocates on the
+    /// audio thread.
     juce::MidiBuffer midiBuffer_;
+    static constexpr int bufferCapacity{4096};
     juce::MidiOutput *midiOut_{nullptr};
 
     static constexpr int midiChannel{10};
     const unsigned int sampleRate_;
 
-    /// Flag indicating if a MIDI note on has been sent without being turned off
-    /// yet.
-    bool midiNoteCurrentlyOn_{false};
-    /// Previous MIDI note, used to determine note change.
-    int lastNote_{-1};
-    /// Previous amplitude of note, used to determine retrigger or ring out.
-    double lastAmp_{0.0};
+    /// MPE lower zone, master channel 1 with member channels 2 to 16.
+    static constexpr int mpeMasterChannel{1};
+    static constexpr int numMpeMemberChannels{15};
+    /// Pitch bend ranges in semitones. MPE default for member channels and
+    /// General MIDI default otherwise.
+    static constexpr int mpePitchBendRange{48};
+    static constexpr int pitchBendRange{2};
+    /// Zone configuration messages, built up front.
+    const juce::MidiBuffer setLowerZone_;
+    const juce::MidiBuffer clearLowerZone_;
+
+    /// Smallest change in bend (semitones) and pressure worth sending.
+    static constexpr double bendDeadband{0.02};
+    static constexpr int pressureDeadband{2};
+    /// Minimum time in seconds between two messages of the same kind.
+    static constexpr double minExpressionInterval{0.01};
+
+    bool mpeEnabled_{false};
+    /// Channel of the sounding note.
+    int activeChannel_{midiChannel};
+    /// Next member channel, counted from the first after the master.
+    int nextMemberChannel_{0};
+    /// Sent note value of the sounding note, -1 when none is sent.
+    int activeNote_{-1};
+
+    /// Pitch of the latest frame.
+    double lastPitch_{0.0};
+    double lastSentBend_{0.0};
+    int lastSentPressure_{-1};
+    juce::int64 lastBendSample_{0};
+    juce::int64 lastPressureSample_{0};
+
+    NoteTracker tracker_;
+
+    /// Pending messages while coalescing, reserved up front. Blocks with
+    /// more events than pendingCapacity are not coalesced.
+    struct PendingMessage {
+        juce::MidiMessage message;
+        int samplePosition;
+        bool keep;
+    };
+    std::vector<PendingMessage> pending_;
+    static constexpr std::size_t pendingCapacity{256};
+
+    /// Samples processed since the stream started. Used to determine Midi
+    /// message timestamp.
+    juce::int64 samplePosition_{0};
+    /// Stream position of the pending block's start. Messages are placed by
+    /// offset from it, which fits an int however long the stream runs.
+    juce::int64 blockStart_{0};
+
+    int getBlockOffset() const {
+        return static_cast<int>(samplePosition_ - blockStart_);
+    }
 
-    static constexpr double defaultAttackThreshold{0.1};
-    static constexpr double defaultReleaseThreshold{0.001};
+    /**
+     *  @brief Picks the channel for a new note, rotating through the member
+     *         channels in MPE mode.
+     */
+    int allocateChannel();
 
-    double attackThreshold_{defaultAttackThreshold};
-    double releaseThreshold_{defaultReleaseThreshold};
+    int getPitchBendRange() const;
 
-    /// Audio app start time. Used to determine Midi message timestamp.
-    const double startTime_;
+    /**
+     *  @brief Pitch bend message for the active channel.
+     *  @param bend - Bend in semitones, clamped to the pitch bend range.
+     */
+    juce::MidiMessage createPitchBend(double bend) const;
+
+    /**
+     *  @brief Timestamps a message at the current stream position and adds it
+     *         to the buffer.
+     */
+    void addMessageNow(juce::MidiMessage message);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiProcessor)
 };
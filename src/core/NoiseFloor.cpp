@@ -0,0 +1,35 @@
+/**
+ *
+ *  @file      NoiseFloor.cpp
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#include "NoiseFloor.h"
+
+anyMidi::NoiseFloor::NoiseFloor(std::size_t numBins, double framesPerSecond)
+    : smoothed_(numBins), floors_(numBins),
+      smoothing_{static_cast<float>(
+          std::exp(-1.0 / (framesPerSecond * smoothingTime)))},
+      riseFactor_{static_cast<float>(
+          juce::Decibels::decibelsToGain(riseRate / framesPerSecond))} {}
+
+void anyMidi::NoiseFloor::update(const float *magnitudes) {
+    if (!initialised_) {
+        std::copy_n(magnitudes, smoothed_.size(), smoothed_.begin());
+        std::copy_n(magnitudes, floors_.size(), floors_.begin());
+        initialised_ = true;
+        return;
+    }
+
+    for (std::size_t bin = 0; bin < floors_.size(); ++bin) {
+        auto &smoothed = smoothed_[bin];
+        smoothed =
+            smoothing_ * smoothed + (1.0F - smoothing_) * magnitudes[bin];
+
+        auto &floor = floors_[bin];
+        floor = std::min(smoothed, std::max(floor, minFloor) * riseFactor_);
+    }
+}
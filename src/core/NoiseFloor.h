@@ -0,0 +1,72 @@
+/**
+ *
+ *  @file      NoiseFloor.h
+ *  @brief     Running per-bin estimate of the spectral noise floor.
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <juce_core/juce_core.h>
+
+namespace anyMidi {
+
+/**
+ *
+ *  @class   NoiseFloor
+ *  @brief   Tracks the noise floor of every FFT bin by minimum statistics.
+ *           Each bin's magnitude is smoothed over a few frames, and the floor
+ *           follows the smoothed magnitude immediately when it falls but
+ *           only creeps upwards when it rises. Notes are short compared to
+ *           the rise time, so they barely lift the floor, while a change of
+ *           gain or pickup is learned within seconds.
+ *
+ */
+class NoiseFloor {
+public:
+    /**
+     *  @brief NoiseFloor object constructor. Allocates all state.
+     *  @param numBins         - Number of bins to track.
+     *  @param framesPerSecond - Rate at which update() is called.
+     */
+    NoiseFloor(std::size_t numBins, double framesPerSecond);
+
+    /**
+     *  @brief Updates the estimate with a new frame.
+     *  @param magnitudes - Magnitudes of at least numBins bins.
+     */
+    void update(const float *magnitudes);
+
+    /**
+     *  @brief Forgets the estimate, so the next frame sets it anew.
+     */
+    void reset() { initialised_ = false; }
+
+    const float *getFloors() const { return floors_.data(); }
+
+    float getFloor(std::size_t bin) const { return floors_[bin]; }
+
+private:
+    /// Time constant of the magnitude smoothing in seconds.
+    static constexpr double smoothingTime{0.05};
+    /// Rate at which the floor may rise, in dB per second.
+    static constexpr double riseRate{3.0};
+    /// Lowest floor the rise starts from, so it can leave digital silence.
+    static constexpr float minFloor{1e-3F};
+
+    std::vector<float> smoothed_;
+    std::vector<float> floors_;
+
+    float smoothing_;  /// Weight of the previous smoothed magnitude.
+    float riseFactor_; /// Largest increase of the floor per frame.
+    bool initialised_{false};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(NoiseFloor)
+};
+
+} // namespace anyMidi
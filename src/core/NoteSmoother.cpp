@@ -0,0 +1,106 @@
+/**
+ *
+ *  @file      NoteSmoother.cpp
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "NoteSmoother.h"
+
+anyMidi::NoteSmoother::NoteSmoother() {
+    constexpr int octave{12};
+    for (int d = 1; d <= band; ++d) {
+        distanceCosts_[d] = changeCost + costPerSemitone * d +
+                            (d == octave ? octaveCost : 0.0F);
+    }
+    reset();
+}
+
+void anyMidi::NoteSmoother::setLag(int frames) {
+    lag_ = juce::jlimit(0, maxLag, frames);
+    reset();
+}
+
+void anyMidi::NoteSmoother::reset() noexcept {
+    // Every path starts in silence.
+    costs_.fill(onsetCost);
+    costs_[0] = 0.0F;
+    frameIndex_ = 0;
+    numFrames_ = 0;
+}
+
+int anyMidi::NoteSmoother::process(const float *scores) noexcept {
+    const float best = *std::max_element(scores + 1, scores + numStates);
+    const float maxEmission = -std::log(minRatio);
+
+    // Silence is likely only when nothing scores at all.
+    emissions_[0] = best > 0.0F ? maxEmission : 0.0F;
+    for (int s = 1; s < numStates; ++s) {
+        const float ratio = best > 0.0F ? scores[s] / best : 0.0F;
+        emissions_[s] = -std::log(std::max(ratio, minRatio));
+    }
+
+    const auto bestPrevious = static_cast<int>(
+        std::min_element(costs_.begin(), costs_.end()) - costs_.begin());
+    const float bestCost = costs_[bestPrevious];
+    auto &back = backPointers_[frameIndex_];
+
+    // Silence is entered from anywhere and stays for free.
+    nextCosts_[0] = costs_[0];
+    back[0] = 0;
+    if (bestCost + silenceCost < nextCosts_[0]) {
+        nextCosts_[0] = bestCost + silenceCost;
+        back[0] = static_cast<std::uint8_t>(bestPrevious);
+    }
+    nextCosts_[0] += emissions_[0];
+
+    for (int s = 1; s < numStates; ++s) {
+        // A leap from the best note, or an onset after silence.
+        float cost = bestCost + leapCost;
+        int from = bestPrevious;
+        if (costs_[0] + onsetCost < cost) {
+            cost = costs_[0] + onsetCost;
+            from = 0;
+        }
+
+        const int first = std::max(1, s - band);
+        const int last = std::min(numStates - 1, s + band);
+        for (int p = first; p <= last; ++p) {
+            const float c = costs_[p] + distanceCosts_[std::abs(s - p)];
+            if (c < cost) {
+                cost = c;
+                from = p;
+            }
+        }
+
+        nextCosts_[s] = cost + emissions_[s];
+        back[s] = static_cast<std::uint8_t>(from);
+    }
+
+    // Only differences between paths matter, so costs are kept near zero.
+    const float lowest =
+        *std::min_element(nextCosts_.begin(), nextCosts_.end());
+    for (int s = 0; s < numStates; ++s) {
+        costs_[s] = nextCosts_[s] - lowest;
+    }
+
+    // Deciding the frame maxLag frames ago takes maxLag + 1 frames.
+    numFrames_ = std::min(numFrames_ + 1, maxLag + 1);
+    frameIndex_ = (frameIndex_ + 1) % maxLag;
+
+    // Follows the best path back to the frame being decided.
+    auto state = static_cast<int>(
+        std::min_element(costs_.begin(), costs_.end()) - costs_.begin());
+    const int steps = std::min(lag_, numFrames_ - 1);
+    int index = frameIndex_;
+    for (int k = 0; k < steps; ++k) {
+        index = (index + maxLag - 1) % maxLag;
+        state = backPointers_[index][state];
+    }
+    return state;
+}
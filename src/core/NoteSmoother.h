@@ -0,0 +1,97 @@
+/**
+ *
+ *  @file      NoteSmoother.h
+ *  @brief     Fixed-lag Viterbi smoothing of the analysed note across frames.
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include <juce_core/juce_core.h>
+
+#include "Salience.h"
+
+namespace anyMidi {
+
+/**
+ *
+ *  @class   NoteSmoother
+ *  @brief   Online hidden Markov model over the MIDI notes, with state 0 for
+ *           silence. The salience scores of every frame are the emissions,
+ *           and transitions cost more the further they jump, with an extra
+ *           cost for octave jumps, so single frame glitches and octave
+ *           errors lose against the note around them. Decoded by Viterbi
+ *           with a fixed lag: each frame decides the note of the frame lag
+ *           frames earlier, having seen the frames since. Transitions are
+ *           only evaluated within a band of semitones, and leaps further
+ *           away from the best previous note at a fixed cost, so a frame
+ *           costs a few thousand additions. All state is preallocated.
+ *
+ */
+class NoteSmoother {
+public:
+    static constexpr int numStates{Salience::numCandidates};
+    static constexpr int maxLag{8};
+
+    NoteSmoother();
+
+    /**
+     *  @brief Sets how many frames a decision waits for. Forgets the frames
+     *         seen so far.
+     */
+    void setLag(int frames);
+
+    int getLag() const { return lag_; }
+
+    /**
+     *  @brief Forgets the frames seen so far.
+     */
+    void reset() noexcept;
+
+    /**
+     *  @brief  Adds the scores of a frame.
+     *  @param  scores - Salience of every note, see Salience::getScores().
+     *  @retval        - Note decided for the frame lag frames ago, or for the
+     *                   oldest frame seen after a reset. 0 for silence.
+     */
+    int process(const float *scores) noexcept;
+
+private:
+    /// Semitones within which transitions are evaluated one by one.
+    static constexpr int band{12};
+    /// Costs are negative log probabilities, in nats.
+    static constexpr float changeCost{2.0F};
+    static constexpr float costPerSemitone{0.1F};
+    static constexpr float octaveCost{2.0F};
+    static constexpr float leapCost{5.0F};
+    static constexpr float onsetCost{1.0F};
+    static constexpr float silenceCost{1.0F};
+    /// Lowest score relative to the best that still counts, bounding the
+    /// emission cost of unlikely notes.
+    static constexpr float minRatio{1e-3F};
+
+    /// Cost of a transition by every distance within the band.
+    std::array<float, band + 1> distanceCosts_{};
+
+    /// Cost of the best path ending in every state.
+    std::array<float, numStates> costs_{};
+    std::array<float, numStates> nextCosts_{};
+    std::array<float, numStates> emissions_{};
+    /// Previous state on the best path into every state, for the last
+    /// maxLag frames, circular.
+    std::array<std::array<std::uint8_t, numStates>, maxLag> backPointers_{};
+    int frameIndex_{0}; /// Slot of backPointers_ written next.
+    int numFrames_{0};  /// Frames since the reset, up to maxLag + 1.
+
+    int lag_{0};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(NoteSmoother)
+};
+
+} // namespace anyMidi
@@ -0,0 +1,170 @@
+/**
+ *
+ *  @file      NoteTracker.cpp
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#include "NoteTracker.h"
+
+namespace {
+using anyMidi::NoteAction;
+using anyMidi::NoteState;
+} // namespace
+
+// clang-format off
+const std::array<std::array<anyMidi::NoteTracker::Transition,
+                            anyMidi::NoteTracker::numEvents>,
+                 anyMidi::NoteTracker::numStates>
+    anyMidi::NoteTracker::transitions{{
+        // Onset, Hold, Lost, Elapsed
+        // Idle
+        {{{NoteState::Attack, NoteAction::NoteOn},
+          {NoteState::Idle, NoteAction::None},
+          {NoteState::Idle, NoteAction::None},
+          {NoteState::Idle, NoteAction::None}}},
+        // Attack: may not be turned off or retriggered yet.
+        {{{NoteState::Attack, NoteAction::None},
+          {NoteState::Attack, NoteAction::None},
+          {NoteState::Attack, NoteAction::None},
+          {NoteState::Sustain, NoteAction::None}}},
+        // Sustain
+        {{{NoteState::Attack, NoteAction::Retrigger},
+          {NoteState::Sustain, NoteAction::None},
+          {NoteState::Release, NoteAction::NoteOff},
+          {NoteState::Sustain, NoteAction::None}}},
+        // Release: may not be turned on again yet.
+        {{{NoteState::Release, NoteAction::None},
+          {NoteState::Release, NoteAction::None},
+          {NoteState::Release, NoteAction::None},
+          {NoteState::Idle, NoteAction::None}}},
+    }};
+// clang-format on
+
+bool anyMidi::NoteTracker::process(int note, double pitch, double amp,
+                                   juce::int64 now, double sampleRate,
+                                   NoteChanges &noteValues) {
+    const double lastPitch = lastPitch_;
+    lastPitch_ = pitch;
+
+    expireTimers(now, sampleRate);
+
+    // Ensures that notes are within midi range.
+    if (note < 0 || note >= numNotes) {
+        return false;
+    }
+
+    // When there's no note currently playing, and the note surpasses the
+    // threshold.
+    if (activeNote_ < 0) {
+        if (amp > attackThreshold_ &&
+            fire(note, NoteEvent::Onset, now) == NoteAction::NoteOn) {
+            noteValues.add(note, true); // Note on
+            activeNote_ = note;
+            lastAmp_ = amp;
+            return true;
+        }
+        return false;
+    }
+
+    // When the sounding note has rung out.
+    if (amp < releaseThreshold_) {
+        if (fire(activeNote_, NoteEvent::Lost, now) == NoteAction::NoteOff) {
+            noteValues.add(activeNote_, false); // Note off
+            activeNote_ = -1;
+            return true;
+        }
+        return false;
+    }
+
+    // When the frame still belongs to the sounding note, it has to be
+    // sufficiently louder to retrigger.
+    if (isSameNote(pitch, lastPitch)) {
+        const bool attacked =
+            amp > lastAmp_ * retriggerRatio && amp > attackThreshold_;
+        lastAmp_ = amp;
+        if (attacked && fire(activeNote_, NoteEvent::Onset, now) ==
+                            NoteAction::Retrigger) {
+            noteValues.add(activeNote_, false); // Note off
+            noteValues.add(activeNote_, true);  // Note on
+            return true;
+        }
+        fire(activeNote_, NoteEvent::Hold, now);
+        return false;
+    }
+
+    // When a different note surpasses the threshold, the sounding note is
+    // turned off before the new one is turned on. Both notes must allow it.
+    if (amp > attackThreshold_ &&
+        peek(activeNote_, NoteEvent::Lost).action == NoteAction::NoteOff &&
+        peek(note, NoteEvent::Onset).action == NoteAction::NoteOn) {
+        fire(activeNote_, NoteEvent::Lost, now);
+        fire(note, NoteEvent::Onset, now);
+        noteValues.add(activeNote_, false); // Note off
+        noteValues.add(note, true);         // Note on
+        activeNote_ = note;
+        lastAmp_ = amp;
+        return true;
+    }
+
+    fire(activeNote_, NoteEvent::Hold, now);
+    return false;
+}
+
+void anyMidi::NoteTracker::reset() {
+    notes_.fill({});
+    activeNote_ = -1;
+    lastAmp_ = 0.0;
+}
+
+anyMidi::NoteState anyMidi::NoteTracker::getState(int note) const {
+    return notes_[static_cast<std::size_t>(note)].state;
+}
+
+const anyMidi::NoteTracker::Transition &
+anyMidi::NoteTracker::peek(int note, NoteEvent event) const {
+    const auto state = static_cast<std::size_t>(getState(note));
+    return transitions[state][static_cast<std::size_t>(event)];
+}
+
+anyMidi::NoteAction anyMidi::NoteTracker::fire(int note, NoteEvent event,
+                                               juce::int64 now) {
+    const auto &transition = peek(note, event);
+    auto &status = notes_[static_cast<std::size_t>(note)];
+    if (transition.next != status.state ||
+        transition.action != NoteAction::None) {
+        status.state = transition.next;
+        status.since = now;
+    }
+    return transition.action;
+}
+
+void anyMidi::NoteTracker::expireTimers(juce::int64 now, double sampleRate) {
+    const auto minOn = static_cast<juce::int64>(minNoteOnTime_ * sampleRate);
+    const auto minOff = static_cast<juce::int64>(minNoteOffTime_ * sampleRate);
+
+    for (int note = 0; note < numNotes; ++note) {
+        const auto &status = notes_[static_cast<std::size_t>(note)];
+        if ((status.state == NoteState::Attack &&
+             now - status.since >= minOn) ||
+            (status.state == NoteState::Release &&
+             now - status.since >= minOff)) {
+            fire(note, NoteEvent::Elapsed, now);
+        }
+    }
+}
+
+bool anyMidi::NoteTracker::isSameNote(double pitch, double lastPitch) const {
+    constexpr double halfSemitone{0.5};
+    constexpr double centsPerSemitone{100.0};
+
+    const double distance = std::abs(pitch - activeNote_);
+    if (distance <= halfSemitone + hysteresisCents_ / centsPerSemitone) {
+        return true;
+    }
+
+    // When the pitch glides away without jumping, it is a bend or vibrato.
+    return distance <= maxBend && std::abs(pitch - lastPitch) <= maxBendStep;
+}
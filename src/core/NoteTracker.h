@@ -0,0 +1,193 @@
+/**
+ *
+ *  @file      NoteTracker.h
+ *  @brief     Table driven note on/off decisions.
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#pragma once
+
+#include <array>
+#include <utility>
+
+#include <juce_core/juce_core.h>
+
+namespace anyMidi {
+
+/**
+ *  @brief States every MIDI note value moves through.
+ */
+enum class NoteState {
+    Idle,    /// Not sounding.
+    Attack,  /// Sounding, but younger than the minimum note on duration.
+    Sustain, /// Sounding, and may be turned off.
+    Release, /// Turned off, but younger than the minimum note off duration.
+    NumStates
+};
+
+/**
+ *  @brief What the analysis of a frame means for a single note.
+ */
+enum class NoteEvent {
+    Onset,   /// Attacked, either new or retriggered.
+    Hold,    /// Still present.
+    Lost,    /// Rung out, or replaced by another note.
+    Elapsed, /// The minimum duration of the current state has passed.
+    NumEvents
+};
+
+enum class NoteAction { None, NoteOn, NoteOff, Retrigger };
+
+/**
+ *
+ *  @struct  NoteChanges
+ *  @brief   Notes to turn on (true) or off (false) after a frame, in order.
+ *           A frame turns at most one note off and one on, so the storage is
+ *           fixed and never allocates.
+ *
+ */
+struct NoteChanges {
+    static constexpr int capacity{2};
+
+    std::array<std::pair<int, bool>, capacity> values{};
+    int size{0};
+
+    void add(int note, bool on) { values[size++] = {note, on}; }
+
+    const std::pair<int, bool> *begin() const { return values.data(); }
+    const std::pair<int, bool> *end() const { return values.data() + size; }
+};
+
+/**
+ *
+ *  @class   NoteTracker
+ *  @brief   Decides which notes to turn on and off from the analysed note
+ *           of every frame. Each note value has its own state, and the
+ *           transitions are looked up in a fixed table. Hysteresis in pitch
+ *           and amplitude, together with minimum note on and off durations,
+ *           keeps flicker between neighbouring notes from reaching the
+ *           output. Monophonic: at most one note sounds at a time.
+ *
+ */
+class NoteTracker {
+public:
+    /// Furthest a note is followed as a bend, in semitones.
+    static constexpr double maxBend{3.0};
+
+    /**
+     *  @brief Feeds the analysis of one frame to the tracker.
+     *  @param note       - Analysed MIDI note value.
+     *  @param pitch      - Tracked pitch as a fractional MIDI note value.
+     *  @param amp        - Amplitude of the note.
+     *  @param now        - Stream position of the frame in samples.
+     *  @param sampleRate - Sample rate of the stream.
+     *  @param noteValues - Notes to turn on or off are added here.
+     *  @retval           - Whether any note is to be turned on or off.
+     */
+    bool process(int note, double pitch, double amp, juce::int64 now,
+                 double sampleRate, NoteChanges &noteValues);
+
+    /**
+     *  @brief Forgets every note, as after all notes off.
+     */
+    void reset();
+
+    NoteState getState(int note) const;
+
+    /**
+     *  @brief  Sounding note, or -1 when none is.
+     */
+    int getActiveNote() const { return activeNote_; }
+
+    double getAttackThreshold() const { return attackThreshold_; }
+    double getReleaseThreshold() const { return releaseThreshold_; }
+    double getHysteresisCents() const { return hysteresisCents_; }
+    double getMinNoteOnTime() const { return minNoteOnTime_; }
+    double getMinNoteOffTime() const { return minNoteOffTime_; }
+
+    void setAttackThreshold(double t) { attackThreshold_ = t; }
+    void setReleaseThreshold(double t) { releaseThreshold_ = t; }
+    void setHysteresisCents(double c) { hysteresisCents_ = c; }
+    void setMinNoteOnTime(double s) { minNoteOnTime_ = s; }
+    void setMinNoteOffTime(double s) { minNoteOffTime_ = s; }
+
+private:
+    static constexpr int numNotes{128};
+
+    static constexpr double defaultAttackThreshold{0.1};
+    static constexpr double defaultReleaseThreshold{0.001};
+    /// Pitch must be this far beyond the midpoint between two notes before
+    /// the neighbour is considered a different note.
+    static constexpr double defaultHysteresisCents{20.0};
+    /// Seconds a note stays on, and off, at the least.
+    static constexpr double defaultMinNoteOnTime{0.04};
+    static constexpr double defaultMinNoteOffTime{0.03};
+
+    /// Amplitude increase of the sounding note that counts as a new attack.
+    static constexpr double retriggerRatio{3.0};
+    /// Largest pitch move between two frames that is followed as a bend.
+    /// Larger jumps are fretted notes.
+    static constexpr double maxBendStep{0.6};
+
+    struct Transition {
+        NoteState next;
+        NoteAction action;
+    };
+
+    static constexpr auto numStates =
+        static_cast<std::size_t>(NoteState::NumStates);
+    static constexpr auto numEvents =
+        static_cast<std::size_t>(NoteEvent::NumEvents);
+
+    /// Transitions indexed by current state and event.
+    static const std::array<std::array<Transition, numEvents>, numStates>
+        transitions;
+
+    struct NoteStatus {
+        NoteState state{NoteState::Idle};
+        juce::int64 since{0}; /// Stream position the state was entered.
+    };
+
+    std::array<NoteStatus, numNotes> notes_{};
+
+    int activeNote_{-1};
+    /// Amplitude of the sounding note in the previous frame.
+    double lastAmp_{0.0};
+    /// Pitch of the previous frame.
+    double lastPitch_{0.0};
+
+    double attackThreshold_{defaultAttackThreshold};
+    double releaseThreshold_{defaultReleaseThreshold};
+    double hysteresisCents_{defaultHysteresisCents};
+    double minNoteOnTime_{defaultMinNoteOnTime};
+    double minNoteOffTime_{defaultMinNoteOffTime};
+
+    /**
+     *  @brief  Looks up the transition of a note without applying it.
+     */
+    const Transition &peek(int note, NoteEvent event) const;
+
+    /**
+     *  @brief  Looks up and applies the transition of a note.
+     *  @retval  - The action of the transition.
+     */
+    NoteAction fire(int note, NoteEvent event, juce::int64 now);
+
+    /**
+     *  @brief Fires Elapsed for every note whose minimum duration has passed.
+     */
+    void expireTimers(juce::int64 now, double sampleRate);
+
+    /**
+     *  @brief  Whether a frame's pitch still belongs to the sounding note,
+     *          either within the hysteresis or as a gradual bend.
+     */
+    bool isSameNote(double pitch, double lastPitch) const;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(NoteTracker)
+};
+
+} // namespace anyMidi
@@ -0,0 +1,77 @@
+/**
+ *
+ *  @file      PeakTable.cpp
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "PeakTable.h"
+
+void anyMidi::PeakTable::build(const float *cleaned, const float *magnitudes,
+                               const float *floors, int numBins,
+                               double binWidth, float scale) noexcept {
+    constexpr float minMagnitude{1e-9F};
+    binWidth_ = binWidth;
+    size_ = 0;
+
+    // Bin 0 is DC and never a partial.
+    for (int bin = 1; bin < numBins && size_ < capacity; ++bin) {
+        const float centre = cleaned[bin];
+        if (centre == 0.0F) {
+            continue;
+        }
+
+        // Parabolic interpolation of the log magnitudes around the lobe's
+        // loudest bin.
+        double offset{0.0};
+        if (bin + 1 < numBins) {
+            const auto logMagnitude = [&](int index) {
+                return std::log(std::max(magnitudes[index], minMagnitude));
+            };
+            const double a = logMagnitude(bin - 1);
+            const double b = logMagnitude(bin);
+            const double c = logMagnitude(bin + 1);
+            const double denominator = a - 2.0 * b + c;
+            if (denominator < 0.0) {
+                offset = juce::jlimit(-0.5, 0.5, 0.5 * (a - c) / denominator);
+            }
+        }
+
+        const auto i = static_cast<std::size_t>(size_++);
+        frequencies_[i] = static_cast<float>((bin + offset) * binWidth);
+        amplitudes_[i] = centre * scale;
+        confidences_[i] = std::max(0.0F, 1.0F - floors[bin] / centre);
+        bins_[i] = bin;
+        harmonics_[i] = 0;
+    }
+}
+
+void anyMidi::PeakTable::assignHarmonics(double fundamental,
+                                         int numHarmonics) noexcept {
+    if (fundamental <= 0.0) {
+        std::fill_n(harmonics_.begin(), size_, 0);
+        return;
+    }
+
+    const auto f0 = static_cast<float>(fundamental);
+    const auto minTolerance = static_cast<float>(binWidth_);
+    // Half a semitone of the harmonic's frequency.
+    const auto relativeTolerance =
+        static_cast<float>(std::pow(2.0, 1.0 / 24.0) - 1.0);
+
+    for (int i = 0; i < size_; ++i) {
+        const float frequency = frequencies_[i];
+        const float h = std::round(frequency / f0);
+        const float tolerance =
+            std::max(minTolerance, h * f0 * relativeTolerance);
+        const bool onHarmonic = h >= 1.0F &&
+                                h <= static_cast<float>(numHarmonics) &&
+                                std::abs(frequency - h * f0) <= tolerance;
+        harmonics_[i] = onHarmonic ? static_cast<int>(h) : 0;
+    }
+}
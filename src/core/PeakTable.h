@@ -0,0 +1,83 @@
+/**
+ *
+ *  @file      PeakTable.h
+ *  @brief     Spectral peaks of one frame, laid out as structure of arrays.
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#pragma once
+
+#include <array>
+
+#include <juce_core/juce_core.h>
+
+namespace anyMidi {
+
+/**
+ *
+ *  @class   PeakTable
+ *  @brief   The lobes left in a gated spectrum, each reduced to one peak with
+ *           an interpolated frequency, its amplitude, the share of it above
+ *           the noise floor and the harmonic of the analysed note it belongs
+ *           to. Every field is a separate cache line aligned array of fixed
+ *           capacity, so the table is filled without allocating and the
+ *           stages reading it loop over contiguous floats. Built once per
+ *           frame and read-only after that.
+ *
+ */
+class PeakTable {
+public:
+    /// Most peaks kept per frame. Peaks are found from the lowest frequency
+    /// up, so an overflowing frame loses its highest peaks.
+    static constexpr int capacity{128};
+
+    /**
+     *  @brief Finds the peaks of a frame. Every bin that passed the gate is
+     *         the centre of a lobe, see SizedForwardFFT::cleanUpBins().
+     *  @param cleaned    - Gated magnitudes, lobes squeezed into one bin.
+     *  @param magnitudes - Magnitudes before gating, for interpolation.
+     *  @param floors     - Noise floor of every bin.
+     *  @param numBins    - Number of bins in the spectrum.
+     *  @param binWidth   - Frequency spacing of the bins.
+     *  @param scale      - Factor from magnitude to amplitude.
+     */
+    void build(const float *cleaned, const float *magnitudes,
+               const float *floors, int numBins, double binWidth,
+               float scale) noexcept;
+
+    /**
+     *  @brief Numbers the peaks that lie on a harmonic of a fundamental, and
+     *         sets the others to 0. A peak is on a harmonic within half a
+     *         semitone, or within a bin for low harmonics.
+     *  @param fundamental  - Frequency of the note. 0 clears every peak.
+     *  @param numHarmonics - Highest harmonic to number.
+     */
+    void assignHarmonics(double fundamental, int numHarmonics) noexcept;
+
+    int size() const { return size_; }
+
+    const float *getFrequencies() const { return frequencies_.data(); }
+    const float *getAmplitudes() const { return amplitudes_.data(); }
+    /// Share of each amplitude above the noise floor, from 0 to 1.
+    const float *getConfidences() const { return confidences_.data(); }
+    const int *getBins() const { return bins_.data(); }
+    /// Harmonic number of each peak, 1 for the fundamental, 0 for none.
+    const int *getHarmonics() const { return harmonics_.data(); }
+
+private:
+    alignas(64) std::array<float, capacity> frequencies_{};
+    alignas(64) std::array<float, capacity> amplitudes_{};
+    alignas(64) std::array<float, capacity> confidences_{};
+    alignas(64) std::array<int, capacity> bins_{};
+    alignas(64) std::array<int, capacity> harmonics_{};
+
+    int size_{0};
+    double binWidth_{0.0};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PeakTable)
+};
+
+} // namespace anyMidi
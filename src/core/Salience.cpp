@@ -0,0 +1,108 @@
+/**
+ *
+ *  @file      Salience.cpp
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "Salience.h"
+
+#include "../util/CpuFeatures.h"
+
+namespace {
+/**
+ *  @brief Adds a weighted gather of the spectrum to the scores. Vectorises to
+ *         gather instructions for the targets that have them.
+ */
+forcedinline void accumulateImpl(float *scores, const float *spectrum,
+                                 const int *bins, float weight, int num) {
+    for (int i = 0; i < num; ++i) {
+        scores[i] += weight * spectrum[bins[i]];
+    }
+}
+
+void accumulateGeneric(float *scores, const float *spectrum, const int *bins,
+                       float weight, int num) {
+    accumulateImpl(scores, spectrum, bins, weight, num);
+}
+
+#if ANYMIDI_MULTIVERSION
+ANYMIDI_TARGET("avx2,fma")
+void accumulateAvx2(float *scores, const float *spectrum, const int *bins,
+                    float weight, int num) {
+    accumulateImpl(scores, spectrum, bins, weight, num);
+}
+
+ANYMIDI_TARGET("avx512f")
+void accumulateAvx512(float *scores, const float *spectrum, const int *bins,
+                      float weight, int num) {
+    accumulateImpl(scores, spectrum, bins, weight, num);
+}
+#endif
+} // namespace
+
+anyMidi::Salience::Salience() : accumulate_{accumulateGeneric} {
+#if ANYMIDI_MULTIVERSION
+    const auto level = getSimdLevel();
+    if (level == SimdLevel::AVX512) {
+        accumulate_ = accumulateAvx512;
+    } else if (level == SimdLevel::AVX2) {
+        accumulate_ = accumulateAvx2;
+    }
+#endif
+
+    for (std::size_t h = 0; h < maxHarmonics; ++h) {
+        weights_[h] = 1.0F / static_cast<float>(h + 1);
+    }
+}
+
+void anyMidi::Salience::prepare(const std::vector<double> &noteFrequencies,
+                                double binWidth, int numBins) {
+    numBins_ = numBins;
+    padded_.assign(static_cast<std::size_t>(numBins) + 1, 0.0F);
+
+    for (int h = 0; h < maxHarmonics; ++h) {
+        for (int c = 0; c < numCandidates; ++c) {
+            const double frequency = noteFrequencies[c] * (h + 1);
+            auto bin = static_cast<int>(std::round(frequency / binWidth));
+            if (bin < 1 || bin >= numBins) {
+                bin = numBins; // Trailing zero bin.
+            }
+            bins_[h][c] = bin;
+        }
+    }
+}
+
+void anyMidi::Salience::setNumHarmonics(int n) {
+    numHarmonics_ = juce::jlimit(1, maxHarmonics, n);
+}
+
+int anyMidi::Salience::process(const float *spectrum) {
+    // Trailing zero bin stays in place for harmonics beyond the spectrum.
+    juce::FloatVectorOperations::copy(padded_.data(), spectrum, numBins_);
+
+    scores_.fill(0.0F);
+    for (int h = 0; h < numHarmonics_; ++h) {
+        accumulate_(scores_.data(), padded_.data(), bins_[h].data(),
+                    weights_[h], numCandidates);
+    }
+
+    // Vectorised maximum, then the first candidate reaching it.
+    const float best =
+        juce::FloatVectorOperations::findMaximum(scores_.data(), numCandidates);
+    if (best <= 0.0F) {
+        return 0;
+    }
+    return static_cast<int>(std::find(scores_.begin(), scores_.end(), best) -
+                            scores_.begin());
+}
+
+float anyMidi::Salience::getHarmonicMagnitude(int candidate,
+                                              int harmonic) const {
+    return padded_[bins_[harmonic][candidate]];
+}
@@ -0,0 +1,89 @@
+/**
+ *
+ *  @file      Salience.h
+ *  @brief     Harmonic sum salience of every MIDI note candidate.
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include <juce_core/juce_core.h>
+
+namespace anyMidi {
+
+/**
+ *
+ *  @class   Salience
+ *  @brief   Scores every MIDI note as a fundamental by summing the spectrum
+ *           at its first harmonics, weighted by 1/h. The bins of every
+ *           candidate and harmonic are looked up in a precomputed table laid
+ *           out harmonic by harmonic, so each harmonic is a single gather
+ *           over all candidates into a dense score array.
+ *
+ */
+class Salience {
+public:
+    static constexpr int numCandidates{128};
+    static constexpr int maxHarmonics{16};
+
+    Salience();
+
+    /**
+     *  @brief Builds the bin table. Allocates, so not for the audio thread.
+     *  @param noteFrequencies - Frequencies of the MIDI notes, indexed by note
+     *                           value.
+     *  @param binWidth        - Frequency spacing of the spectrum bins.
+     *  @param numBins         - Number of bins in the spectrum.
+     */
+    void prepare(const std::vector<double> &noteFrequencies, double binWidth,
+                 int numBins);
+
+    void setNumHarmonics(int n);
+
+    int getNumHarmonics() const { return numHarmonics_; }
+
+    /**
+     *  @brief  Scores all candidates for a spectrum.
+     *  @param  spectrum - Magnitudes of numBins bins.
+     *  @retval          - Note value with the highest score, 0 when the
+     *                     spectrum is silent.
+     */
+    int process(const float *spectrum);
+
+    const float *getScores() const { return scores_.data(); }
+
+    /**
+     *  @brief  Magnitude found at a harmonic of a candidate in the last
+     *          processed spectrum.
+     *  @param  candidate - MIDI note value.
+     *  @param  harmonic  - Zero based harmonic index, 0 is the fundamental.
+     */
+    float getHarmonicMagnitude(int candidate, int harmonic) const;
+
+private:
+    /// Bin of every harmonic of every candidate, harmonic major. Harmonics
+    /// beyond the spectrum point to a trailing zero bin.
+    std::array<std::array<int, numCandidates>, maxHarmonics> bins_{};
+    std::array<float, maxHarmonics> weights_{};
+    std::array<float, numCandidates> scores_{};
+
+    /// Copy of the spectrum followed by the zero bin.
+    std::vector<float> padded_;
+    int numBins_{0};
+
+    int numHarmonics_{1};
+
+    using AccumulateKernel = void (*)(float *, const float *, const int *,
+                                      float, int);
+    AccumulateKernel accumulate_;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Salience)
+};
+
+} // namespace anyMidi
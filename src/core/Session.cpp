@@ -0,0 +1,184 @@
+/**
+ *
+ *  @file      Session.cpp
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#include <array>
+#include <cmath>
+#include <iostream>
+
+#include "AudioProcessor.h"
+#include "Session.h"
+
+#include "../util/Globals.h"
+#include "../util/Logger.h"
+
+namespace {
+/// Keys of the settings in a session file, by parameter.
+constexpr std::array<const char *,
+                     static_cast<std::size_t>(
+                         anyMidi::Parameter::NumParameters)>
+    settingKeys{"attackThreshold",     "releaseThreshold",
+                "numPartials",         "lowCutFrequency",
+                "mpe",                 "windowingFunction",
+                "adaptiveWindow",      "smoothingLag",
+                "incrementalAnalysis", "slidingTracking"};
+} // namespace
+
+bool anyMidi::loadSession(const juce::File &file,
+                          std::vector<InstrumentConfig> &instruments) {
+    juce::var session;
+    const auto result = juce::JSON::parse(file.loadFileAsString(), session);
+    if (result.failed()) {
+        anyMidi::log(LogLevel::Error, "Failed to parse session {}: {}",
+                     file.getFullPathName().toRawUTF8(),
+                     result.getErrorMessage().toRawUTF8());
+        return false;
+    }
+
+    const auto *entries = session["instruments"].getArray();
+    if (entries == nullptr) {
+        anyMidi::log(LogLevel::Error, "Session {} has no instruments array",
+                     file.getFullPathName().toRawUTF8());
+        return false;
+    }
+
+    instruments.clear();
+    juce::StringArray names;
+    for (const auto &entry : *entries) {
+        InstrumentConfig config;
+        config.name = entry["name"].toString();
+        config.inputChannel = entry.getProperty("input", -1);
+        config.midiOutput = entry["midiOutput"].toString();
+
+        // Names have to be unique, since virtual ports are named after them.
+        if (config.name.isEmpty() || names.contains(config.name) ||
+            config.inputChannel < 0) {
+            anyMidi::log(LogLevel::Error,
+                         "Session {}: instrument {} needs a unique name and "
+                         "an input channel",
+                         file.getFullPathName().toRawUTF8(),
+                         static_cast<int>(instruments.size()));
+            return false;
+        }
+        names.add(config.name);
+
+        const int fftSize = entry.getProperty("fftSize", 0);
+        if (fftSize != 0) {
+            const int order = juce::findHighestSetBit(
+                static_cast<juce::uint32>(fftSize));
+            if (!juce::isPowerOfTwo(fftSize) || order < ForwardFFT::minOrder ||
+                order > ForwardFFT::maxOrder) {
+                anyMidi::log(LogLevel::Error,
+                             "Session {}: fftSize of {} must be a power of two "
+                             "from {} to {}",
+                             file.getFullPathName().toRawUTF8(),
+                             config.name.toRawUTF8(),
+                             1 << ForwardFFT::minOrder,
+                             1 << ForwardFFT::maxOrder);
+                return false;
+            }
+            config.fftOrder = order;
+        }
+
+        for (std::size_t i = 0; i < settingKeys.size(); ++i) {
+            const auto value = entry[settingKeys[i]];
+            if (!value.isVoid()) {
+                config.settings.push_back(
+                    {static_cast<Parameter>(i), static_cast<double>(value)});
+            }
+        }
+
+        instruments.push_back(config);
+    }
+
+    if (instruments.empty()) {
+        anyMidi::log(LogLevel::Error, "Session {} has no instruments",
+                     file.getFullPathName().toRawUTF8());
+        return false;
+    }
+
+    anyMidi::log(LogLevel::Info, "Loaded session of {} instruments from {}",
+                 static_cast<int>(instruments.size()),
+                 file.getFullPathName().toRawUTF8());
+    return true;
+}
+
+void anyMidi::printSessionBenchmark() {
+    constexpr double sampleRate{48000.0};
+    constexpr int blockSize{256};
+    constexpr int numBlocks{
+        static_cast<int>(10 * sampleRate / blockSize)}; // 10 seconds.
+    constexpr std::array<int, 4> sessionSizes{1, 2, 4, 8};
+    constexpr double usPerSecond{1e6};
+
+    std::cout << "instruments,us per block,us per instrument,"
+                 "realtime load\n";
+
+    double singleUs{0.0};
+    for (const int numInstruments : sessionSizes) {
+        juce::ValueTree tree{anyMidi::ROOT_ID};
+        tree.addChild(juce::ValueTree{anyMidi::AUDIO_PROC_ID}, -1, nullptr);
+        tree.addChild(juce::ValueTree{anyMidi::GUI_ID}, -1, nullptr);
+
+        std::vector<InstrumentConfig> instruments;
+        for (int i = 0; i < numInstruments; ++i) {
+            instruments.push_back({"Instrument " + juce::String{i + 1}, i,
+                                   {}, {}});
+        }
+
+        // No device or MIDI output is opened, blocks are fed by hand.
+        AudioProcessor processor{sampleRate, tree, instruments};
+        processor.prepareToPlay(blockSize, sampleRate);
+
+        // A held note a semitone apart on every input, so each instrument
+        // runs its full analysis rather than idling behind the gate.
+        juce::AudioSampleBuffer buffer{numInstruments, blockSize};
+        constexpr double firstNote{110.0};
+        constexpr double semitone{1.0594630943592953};
+        constexpr float level{0.5F};
+        juce::int64 sample{0};
+
+        juce::int64 elapsedTicks{0};
+        for (int block = 0; block < numBlocks; ++block) {
+            for (int ch = 0; ch < numInstruments; ++ch) {
+                const double phaseStep = juce::MathConstants<double>::twoPi *
+                                         firstNote * std::pow(semitone, ch) /
+                                         sampleRate;
+                auto *samples = buffer.getWritePointer(ch);
+                for (int i = 0; i < blockSize; ++i) {
+                    samples[i] = level * static_cast<float>(std::sin(
+                                             phaseStep * (sample + i)));
+                }
+            }
+            sample += blockSize;
+
+            const auto start = juce::Time::getHighResolutionTicks();
+            processor.getNextAudioBlock(
+                juce::AudioSourceChannelInfo{&buffer, 0, blockSize});
+            elapsedTicks += juce::Time::getHighResolutionTicks() - start;
+        }
+
+        const double blockUs =
+            juce::Time::highResolutionTicksToSeconds(elapsedTicks) *
+            usPerSecond / numBlocks;
+        if (numInstruments == 1) {
+            singleUs = blockUs;
+        }
+
+        // Cost of every instrument past the first, which also carries the
+        // callback's fixed overhead.
+        const double perInstrumentUs =
+            numInstruments > 1
+                ? (blockUs - singleUs) / (numInstruments - 1)
+                : blockUs;
+        const double load = blockUs / (blockSize / sampleRate * usPerSecond);
+
+        std::cout << numInstruments << "," << blockUs << ","
+                  << perInstrumentUs << "," << load << "\n";
+    }
+}
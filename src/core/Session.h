@@ -0,0 +1,42 @@
+/**
+ *
+ *  @file      Session.h
+ *  @brief     Loading of multi-instrument sessions and their benchmark.
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <juce_core/juce_core.h>
+
+#include "InstrumentSlot.h"
+
+namespace anyMidi {
+
+/**
+ *  @brief  Reads the instruments of a session file. The file is a JSON
+ *          object with an "instruments" array, where each instrument has a
+ *          "name", an "input" channel index, and optionally a "midiOutput"
+ *          device name and any of "attackThreshold", "releaseThreshold",
+ *          "numPartials", "lowCutFrequency", "mpe" and "windowingFunction".
+ *  @param  file        - Session file to read.
+ *  @param  instruments - Destination of the instruments, in file order.
+ *  @retval             - False if the file could not be parsed or holds no
+ *                        valid instrument. The reason is logged.
+ */
+bool loadSession(const juce::File &file,
+                 std::vector<InstrumentConfig> &instruments);
+
+/**
+ *  @brief  Prints the time a device-less AudioProcessor spends per block for
+ *          sessions of increasing size, and what each added instrument costs,
+ *          to standard output.
+ */
+void printSessionBenchmark();
+
+} // namespace anyMidi
@@ -0,0 +1,43 @@
+/**
+ *
+ *  @file      SilenceGate.cpp
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#include <algorithm>
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+#include "SilenceGate.h"
+
+void anyMidi::SilenceGate::prepare(double sampleRate) {
+    holdSamples_ = static_cast<juce::int64>(sampleRate * holdTime);
+    quietSamples_ = 0;
+    open_ = true;
+}
+
+bool anyMidi::SilenceGate::process(const float *samples, int numSamples) {
+    if (numSamples <= 0) {
+        return open_;
+    }
+
+    const auto range =
+        juce::FloatVectorOperations::findMinAndMax(samples, numSamples);
+    const float peak = std::max(-range.getStart(), range.getEnd());
+
+    if (peak >= openThreshold) {
+        open_ = true;
+    }
+
+    if (peak >= closeThreshold) {
+        quietSamples_ = 0;
+    } else if (open_) {
+        quietSamples_ += numSamples;
+        open_ = quietSamples_ < holdSamples_;
+    }
+
+    return open_;
+}
@@ -0,0 +1,58 @@
+/**
+ *
+ *  @file      SilenceGate.h
+ *  @brief     Block level gate skipping analysis of silent input.
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+namespace anyMidi {
+
+/**
+ *
+ *  @class   SilenceGate
+ *  @brief   Decides per block whether the input is worth analysing, from the
+ *           peak of the filtered samples. Opens as soon as a block peaks
+ *           above the open threshold, and only closes after the input has
+ *           stayed below the lower close threshold for the hold time, so
+ *           decaying notes are followed to their release.
+ *
+ */
+class SilenceGate {
+public:
+    /// Peak that opens the gate, -60 dBFS.
+    static constexpr float openThreshold{0.001F};
+    /// Peak the input has to stay below for the gate to close, -66 dBFS.
+    static constexpr float closeThreshold{0.0005F};
+    /// Time in seconds the input has to stay below the close threshold.
+    static constexpr double holdTime{0.5};
+
+    /**
+     *  @brief Opens the gate and sets the hold time for a new stream.
+     *  @param sampleRate - Sample rate of the stream.
+     */
+    void prepare(double sampleRate);
+
+    /**
+     *  @brief  Updates the gate with a block of samples.
+     *  @param  samples    - Block of samples.
+     *  @param  numSamples - Number of samples in the block.
+     *  @retval            - Whether the gate is open for the block.
+     */
+    bool process(const float *samples, int numSamples);
+
+    bool isOpen() const { return open_; }
+
+private:
+    bool open_{true};
+    juce::int64 holdSamples_{0};
+    juce::int64 quietSamples_{0}; /// Samples below the close threshold.
+};
+
+} // namespace anyMidi
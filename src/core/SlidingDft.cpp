@@ -0,0 +1,111 @@
+/**
+ *
+ *  @file      SlidingDft.cpp
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#include <cmath>
+
+#include "SlidingDft.h"
+
+anyMidi::SlidingDft::SlidingDft(int size)
+    : size_{size}, dampingToSize_{std::pow(damping, size)},
+      history_(static_cast<std::size_t>(size), 0.0F) {}
+
+void anyMidi::SlidingDft::push(float sample) noexcept {
+    const double leaving = dampingToSize_ * history_[historyIndex_];
+    history_[historyIndex_] = sample;
+    if (++historyIndex_ == size_) {
+        historyIndex_ = 0;
+    }
+
+    // X(n) = r e^(j 2 pi k / N) X(n - 1) + x(n) - r^N x(n - N)
+    const double input = sample - leaving;
+    const int numBins = numPartials_ * binsPerPartial;
+    for (int b = 0; b < numBins; ++b) {
+        const double re = rotationRe_[b] * re_[b] - rotationIm_[b] * im_[b];
+        const double im = rotationRe_[b] * im_[b] + rotationIm_[b] * re_[b];
+        re_[b] = re + input;
+        im_[b] = im;
+    }
+
+    // Hann window as a kernel over the neighbouring bins.
+    for (int p = 0; p < numPartials_; ++p) {
+        const int b = p * binsPerPartial;
+        const double re = 0.5 * re_[b + 1] - 0.25 * (re_[b] + re_[b + 2]);
+        const double im = 0.5 * im_[b + 1] - 0.25 * (im_[b] + im_[b + 2]);
+
+        const double advanceRe = re * lastRe_[p] + im * lastIm_[p];
+        const double advanceIm = im * lastRe_[p] - re * lastIm_[p];
+        advanceRe_[p] = phaseSmoothing * advanceRe_[p] +
+                        (1.0 - phaseSmoothing) * advanceRe;
+        advanceIm_[p] = phaseSmoothing * advanceIm_[p] +
+                        (1.0 - phaseSmoothing) * advanceIm;
+
+        lastRe_[p] = re;
+        lastIm_[p] = im;
+    }
+}
+
+void anyMidi::SlidingDft::track(const int *bins, int num) noexcept {
+    numPartials_ = juce::jmin(num, maxPartials);
+
+    for (int p = 0; p < numPartials_; ++p) {
+        centres_[p] = bins[p];
+
+        for (int n = 0; n < binsPerPartial; ++n) {
+            const int b = p * binsPerPartial + n;
+            const double angle = juce::MathConstants<double>::twoPi *
+                                 (bins[p] - 1 + n) / size_;
+            rotationRe_[b] = damping * std::cos(angle);
+            rotationIm_[b] = damping * std::sin(angle);
+
+            // Direct DFT of the history, newest sample first.
+            double re{0.0};
+            double im{0.0};
+            double weightRe{1.0};
+            double weightIm{0.0};
+            int index = historyIndex_;
+            for (int m = 0; m < size_; ++m) {
+                index = index == 0 ? size_ - 1 : index - 1;
+                re += history_[index] * weightRe;
+                im += history_[index] * weightIm;
+
+                const double nextRe =
+                    weightRe * rotationRe_[b] - weightIm * rotationIm_[b];
+                weightIm =
+                    weightRe * rotationIm_[b] + weightIm * rotationRe_[b];
+                weightRe = nextRe;
+            }
+            re_[b] = re;
+            im_[b] = im;
+        }
+
+        const int b = p * binsPerPartial;
+        lastRe_[p] = 0.5 * re_[b + 1] - 0.25 * (re_[b] + re_[b + 2]);
+        lastIm_[p] = 0.5 * im_[b + 1] - 0.25 * (im_[b] + im_[b + 2]);
+        advanceRe_[p] = 0.0;
+        advanceIm_[p] = 0.0;
+    }
+}
+
+float anyMidi::SlidingDft::getMagnitude(int partial) const noexcept {
+    return static_cast<float>(std::hypot(lastRe_[partial], lastIm_[partial]));
+}
+
+double anyMidi::SlidingDft::getFrequency(int partial) const noexcept {
+    if (advanceRe_[partial] == 0.0 && advanceIm_[partial] == 0.0) {
+        return centres_[partial];
+    }
+    return std::atan2(advanceIm_[partial], advanceRe_[partial]) * size_ /
+           juce::MathConstants<double>::twoPi;
+}
+
+void anyMidi::SlidingDft::reset() noexcept {
+    std::fill(history_.begin(), history_.end(), 0.0F);
+    historyIndex_ = 0;
+    numPartials_ = 0;
+}
@@ -0,0 +1,114 @@
+/**
+ *
+ *  @file      SlidingDft.h
+ *  @brief     Sample by sample spectrum of a few tracked partials.
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include <juce_core/juce_core.h>
+
+namespace anyMidi {
+
+/**
+ *
+ *  @class   SlidingDft
+ *  @brief   Sliding DFT over the same window length as the FFT, updating
+ *           only the bins of the tracked partials on every sample. Each
+ *           partial is three bins, combined into a Hann windowed value, so a
+ *           sample costs a few multiply-adds per partial instead of a
+ *           transform per frame. The recursion is damped slightly to keep
+ *           rounding errors from accumulating. A partial's frequency is
+ *           measured from how fast its phase advances.
+ *
+ */
+class SlidingDft {
+public:
+    static constexpr int maxPartials{8};
+
+    /**
+     *  @brief SlidingDft object constructor. Allocates the sample history.
+     *  @param size - Window length in samples, the size of the FFT.
+     */
+    explicit SlidingDft(int size);
+
+    /**
+     *  @brief Adds a sample, updating the tracked partials. Real-time safe.
+     */
+    void push(float sample) noexcept;
+
+    /**
+     *  @brief Starts tracking a new set of partials. Their values are
+     *         computed from the sample history, so they are valid right
+     *         away. Real-time safe, but costs a DFT of the window per bin.
+     *  @param bins - Centre bin of each partial, from 1 up to below half the
+     *                size.
+     *  @param num  - Number of partials, at most maxPartials. 0 stops
+     *                tracking.
+     */
+    void track(const int *bins, int num) noexcept;
+
+    int getNumPartials() const { return numPartials_; }
+
+    /**
+     *  @brief  Hann windowed magnitude of a partial, in the unscaled units of
+     *          the DFT.
+     */
+    float getMagnitude(int partial) const noexcept;
+
+    /**
+     *  @brief  Frequency of a partial in bins, from the phase advance over
+     *          the last few samples. The centre bin until it has advanced.
+     */
+    double getFrequency(int partial) const noexcept;
+
+    /**
+     *  @brief Clears the sample history and stops tracking.
+     */
+    void reset() noexcept;
+
+private:
+    /// Bins per partial: the centre and its neighbours, for the window.
+    static constexpr int binsPerPartial{3};
+    static constexpr int maxBins{maxPartials * binsPerPartial};
+    /// Pole radius of the recursion, just inside the unit circle.
+    static constexpr double damping{0.99999};
+    /// Weight of the previous phase advance in its running average.
+    static constexpr double phaseSmoothing{0.9};
+
+    const int size_;
+    /// damping to the power of size, scaling the sample leaving the window.
+    const double dampingToSize_;
+
+    std::vector<float> history_;
+    int historyIndex_{0}; /// Oldest sample, overwritten next.
+
+    /// Bins of every partial, laid out partial by partial as lower, centre
+    /// and upper neighbour.
+    alignas(64) std::array<double, maxBins> re_{};
+    alignas(64) std::array<double, maxBins> im_{};
+    /// Rotation of each bin per sample, including the damping.
+    alignas(64) std::array<double, maxBins> rotationRe_{};
+    alignas(64) std::array<double, maxBins> rotationIm_{};
+
+    std::array<int, maxPartials> centres_{};
+    /// Windowed value of every partial at the previous sample.
+    std::array<double, maxPartials> lastRe_{};
+    std::array<double, maxPartials> lastIm_{};
+    /// Running average of the windowed value times the conjugate of the
+    /// previous one. Its angle is the phase advance per sample.
+    std::array<double, maxPartials> advanceRe_{};
+    std::array<double, maxPartials> advanceIm_{};
+    int numPartials_{0};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SlidingDft)
+};
+
+} // namespace anyMidi
@@ -0,0 +1,60 @@
+/**
+ *
+ *  @file      SpectrumSnapshot.h
+ *  @brief     Analysis state published from the audio thread for display.
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#pragma once
+
+#include <array>
+
+#include <juce_core/juce_core.h>
+
+#include "../util/TripleBuffer.h"
+
+namespace anyMidi {
+
+/**
+ *
+ *  @struct  SpectrumSnapshot
+ *  @brief   Magnitude spectrum, chosen partials and decided note of one
+ *           analysed FFT frame.
+ *
+ */
+struct SpectrumSnapshot {
+    static constexpr std::size_t maxBins{4096};
+    static constexpr std::size_t maxPartials{16};
+
+    std::array<float, maxBins> magnitudes{};
+    std::size_t numBins{0};
+    double binWidth{0.0}; /// Frequency spacing of the bins in Hz.
+
+    std::array<float, maxPartials> partialFrequencies{};
+    std::array<float, maxPartials> partialAmplitudes{};
+    std::size_t numPartials{0};
+
+    int note{-1}; /// Analysed note value, -1 when nothing is detected.
+    float amplitude{0.0F};
+    bool noteOn{false}; /// Whether a MIDI note is currently sounding.
+
+    juce::uint32 frame{0}; /// Increases with every published frame.
+};
+
+/**
+ *
+ *  @class   SpectrumPublisher
+ *  @brief   Triple buffered spectrum snapshots, reference counted so it can
+ *           be passed to the GUI through the ValueTree.
+ *
+ */
+class SpectrumPublisher : public juce::ReferenceCountedObject,
+                          public TripleBuffer<SpectrumSnapshot> {
+public:
+    using Ptr = juce::ReferenceCountedObjectPtr<SpectrumPublisher>;
+};
+
+} // namespace anyMidi
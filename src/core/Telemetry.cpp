@@ -0,0 +1,210 @@
+/**
+ *
+ *  @file      Telemetry.cpp
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#include "Telemetry.h"
+#include "../util/Globals.h"
+
+#if JUCE_INTEL
+#if JUCE_MSVC
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+const char *anyMidi::getStageName(const Stage stage) {
+    switch (stage) {
+    case Stage::Filter:
+        return "Filter";
+    case Stage::FFT:
+        return "FFT";
+    case Stage::CleanUpBins:
+        return "Clean up bins";
+    case Stage::Salience:
+        return "Salience";
+    case Stage::Peaks:
+        return "Peak table";
+    case Stage::NoteDecision:
+        return "Note decision";
+    case Stage::PitchTracking:
+        return "Pitch tracking";
+    case Stage::MidiSend:
+        return "MIDI send";
+    case Stage::NumStages:
+        break;
+    }
+    return "";
+}
+
+anyMidi::Telemetry::Telemetry()
+    : startCycles_{readCycleCounter()},
+      startSeconds_{juce::Time::getMillisecondCounterHiRes() * msToSec} {}
+
+juce::uint64 anyMidi::Telemetry::readCycleCounter() noexcept {
+#if JUCE_INTEL
+    return __rdtsc();
+#else
+    return static_cast<juce::uint64>(juce::Time::getHighResolutionTicks());
+#endif
+}
+
+std::size_t anyMidi::Telemetry::getThreadSlot() noexcept {
+    static std::atomic<std::size_t> nextSlot{0};
+    // Threads beyond maxThreads share slots, which is still correct since
+    // counters are atomic, only slightly slower.
+    thread_local const std::size_t slot =
+        nextSlot.fetch_add(1, std::memory_order_relaxed) % maxThreads;
+    return slot;
+}
+
+void anyMidi::Telemetry::addSample(const Stage stage,
+                                   const juce::uint64 cycles) noexcept {
+    auto &counter =
+        counters_[getThreadSlot()][static_cast<std::size_t>(stage)];
+
+    counter.cycles.fetch_add(cycles, std::memory_order_relaxed);
+    counter.calls.fetch_add(1, std::memory_order_relaxed);
+    if (cycles > counter.maxCycles.load(std::memory_order_relaxed)) {
+        counter.maxCycles.store(cycles, std::memory_order_relaxed);
+    }
+}
+
+void anyMidi::Telemetry::addCallback(const juce::uint64 cycles,
+                                     const double blockDuration) noexcept {
+    const auto elapsedCycles = readCycleCounter() - startCycles_;
+    const double elapsed =
+        juce::Time::getMillisecondCounterHiRes() * msToSec - startSeconds_;
+    if (elapsed <= 0.0 || blockDuration <= 0.0) {
+        return;
+    }
+
+    const double cyclesPerSecond =
+        static_cast<double>(elapsedCycles) / elapsed;
+    const double load =
+        static_cast<double>(cycles) / cyclesPerSecond / blockDuration;
+
+    // Exponential smoothing, reaching the new load within a few hundred
+    // callbacks.
+    constexpr double smoothing{0.01};
+    const double previous = callbackLoad_.load(std::memory_order_relaxed);
+    callbackLoad_.store(previous + smoothing * (load - previous),
+                        std::memory_order_relaxed);
+}
+
+void anyMidi::Telemetry::setMidiQueueDepth(const int depth) noexcept {
+    if (depth > midiQueueDepth_.load(std::memory_order_relaxed)) {
+        midiQueueDepth_.store(depth, std::memory_order_relaxed);
+    }
+}
+
+void anyMidi::Telemetry::resetMidiQueueDepth() noexcept {
+    midiQueueDepth_.store(0, std::memory_order_relaxed);
+}
+
+void anyMidi::Telemetry::setXRunCount(const int xRuns) noexcept {
+    xRuns_.store(xRuns, std::memory_order_relaxed);
+}
+
+anyMidi::Telemetry::Snapshot anyMidi::Telemetry::getSnapshot() const {
+    Snapshot snapshot;
+
+    for (const auto &threadCounters : counters_) {
+        for (std::size_t i = 0; i < numStages; ++i) {
+            auto &stats = snapshot.stages[i];
+            const auto &counter = threadCounters[i];
+            stats.cycles += counter.cycles.load(std::memory_order_relaxed);
+            stats.calls += counter.calls.load(std::memory_order_relaxed);
+            stats.maxCycles =
+                std::max(stats.maxCycles,
+                         counter.maxCycles.load(std::memory_order_relaxed));
+        }
+    }
+
+    const double elapsed =
+        juce::Time::getMillisecondCounterHiRes() * msToSec - startSeconds_;
+    if (elapsed > 0.0) {
+        snapshot.cyclesPerSecond =
+            static_cast<double>(readCycleCounter() - startCycles_) / elapsed;
+    }
+
+    snapshot.callbackLoad = callbackLoad_.load(std::memory_order_relaxed);
+    snapshot.xRuns = xRuns_.load(std::memory_order_relaxed);
+    snapshot.midiQueueDepth =
+        midiQueueDepth_.load(std::memory_order_relaxed);
+
+    return snapshot;
+}
+
+void anyMidi::Telemetry::reset() noexcept {
+    for (auto &threadCounters : counters_) {
+        for (auto &counter : threadCounters) {
+            counter.cycles.store(0, std::memory_order_relaxed);
+            counter.calls.store(0, std::memory_order_relaxed);
+            counter.maxCycles.store(0, std::memory_order_relaxed);
+        }
+    }
+    callbackLoad_.store(0.0, std::memory_order_relaxed);
+    midiQueueDepth_.store(0, std::memory_order_relaxed);
+}
+
+double anyMidi::Telemetry::Snapshot::toMicroseconds(
+    const juce::uint64 cycles) const {
+    constexpr double usPerSecond{1.0e6};
+    if (cyclesPerSecond <= 0.0) {
+        return 0.0;
+    }
+    return static_cast<double>(cycles) / cyclesPerSecond * usPerSecond;
+}
+
+juce::String anyMidi::Telemetry::Snapshot::toCsv() const {
+    juce::String csv{"stage,calls,total_cycles,max_cycles,mean_us,max_us"};
+    csv << juce::newLine;
+
+    for (std::size_t i = 0; i < numStages; ++i) {
+        const auto &stats = stages[i];
+        const double mean =
+            stats.calls > 0 ? toMicroseconds(stats.cycles) /
+                                  static_cast<double>(stats.calls)
+                            : 0.0;
+        csv << getStageName(static_cast<Stage>(i)) << ","
+            << juce::String(stats.calls) << "," << juce::String(stats.cycles)
+            << "," << juce::String(stats.maxCycles) << "," << mean << ","
+            << toMicroseconds(stats.maxCycles) << juce::newLine;
+    }
+
+    csv << juce::newLine << "callback_load,xruns,midi_queue_depth"
+        << juce::newLine << callbackLoad << "," << xRuns << ","
+        << midiQueueDepth << juce::newLine;
+    return csv;
+}
+
+juce::String anyMidi::Telemetry::Snapshot::toJson() const {
+    juce::Array<juce::var> stageArray;
+    for (std::size_t i = 0; i < numStages; ++i) {
+        const auto &stats = stages[i];
+        auto stage = std::make_unique<juce::DynamicObject>();
+        stage->setProperty("stage", getStageName(static_cast<Stage>(i)));
+        stage->setProperty("calls", static_cast<juce::int64>(stats.calls));
+        stage->setProperty("totalCycles",
+                           static_cast<juce::int64>(stats.cycles));
+        stage->setProperty("maxCycles",
+                           static_cast<juce::int64>(stats.maxCycles));
+        stage->setProperty("maxMicroseconds", toMicroseconds(stats.maxCycles));
+        stageArray.add(stage.release());
+    }
+
+    auto root = std::make_unique<juce::DynamicObject>();
+    root->setProperty("stages", stageArray);
+    root->setProperty("cyclesPerSecond", cyclesPerSecond);
+    root->setProperty("callbackLoad", callbackLoad);
+    root->setProperty("xRuns", xRuns);
+    root->setProperty("midiQueueDepth", midiQueueDepth);
+
+    return juce::JSON::toString(juce::var(root.release()));
+}
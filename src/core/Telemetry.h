@@ -0,0 +1,188 @@
+/**
+ *
+ *  @file      Telemetry.h
+ *  @brief     Low overhead timing counters for the stages of the pipeline.
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+
+#include <juce_core/juce_core.h>
+
+#include "../util/MpscQueue.h"
+
+namespace anyMidi {
+
+/**
+ *  @brief Timed stages of the audio to MIDI pipeline.
+ */
+enum class Stage {
+    Filter,
+    FFT,
+    CleanUpBins,
+    Salience,
+    Peaks,
+    NoteDecision,
+    PitchTracking,
+    MidiSend,
+    NumStages
+};
+
+constexpr auto numStages = static_cast<std::size_t>(Stage::NumStages);
+
+const char *getStageName(Stage stage);
+
+/**
+ *
+ *  @struct  StageStats
+ *  @brief   Accumulated timing of a single stage.
+ *
+ */
+struct StageStats {
+    juce::uint64 cycles{0};
+    juce::uint64 calls{0};
+    juce::uint64 maxCycles{0};
+};
+
+/**
+ *
+ *  @class   Telemetry
+ *  @brief   Always-on counters of cycles spent per pipeline stage, along with
+ *           callback load, xruns and MIDI queue depth. Every thread writes to
+ *           its own cache line padded slot, so recording is a handful of
+ *           relaxed atomic operations and never blocks. Reference counted so
+ *           it can be passed to the GUI through the ValueTree.
+ *
+ */
+class Telemetry : public juce::ReferenceCountedObject {
+public:
+    using Ptr = juce::ReferenceCountedObjectPtr<Telemetry>;
+
+    /**
+     *
+     *  @struct  Snapshot
+     *  @brief   Counters summed over all threads at one point in time.
+     *
+     */
+    struct Snapshot {
+        std::array<StageStats, numStages> stages{};
+        double cyclesPerSecond{0.0};
+        double callbackLoad{0.0}; /// Fraction of the block duration in use.
+        int xRuns{0};
+        int midiQueueDepth{0}; /// Largest MIDI block since last peak reset.
+
+        /**
+         *  @brief  Converts a number of cycles to microseconds.
+         */
+        double toMicroseconds(juce::uint64 cycles) const;
+
+        juce::String toCsv() const;
+        juce::String toJson() const;
+    };
+
+    Telemetry();
+
+    /**
+     *  @brief  Reads the CPU time stamp counter, falling back on the high
+     *          resolution timer on other architectures.
+     */
+    static juce::uint64 readCycleCounter() noexcept;
+
+    /**
+     *  @brief Records one call to a stage.
+     *  @param stage  - Stage that was run.
+     *  @param cycles - Cycles spent in the stage.
+     */
+    void addSample(Stage stage, juce::uint64 cycles) noexcept;
+
+    /**
+     *  @brief Records time spent in an audio callback, updating the smoothed
+     *         callback load.
+     *  @param cycles         - Cycles spent in the callback.
+     *  @param blockDuration  - Real time duration of the block in seconds.
+     */
+    void addCallback(juce::uint64 cycles, double blockDuration) noexcept;
+
+    void setMidiQueueDepth(int depth) noexcept;
+
+    /**
+     *  @brief Starts a new MIDI queue depth peak. Called by the one periodic
+     *         publisher of snapshots, so other readers see the same peak.
+     */
+    void resetMidiQueueDepth() noexcept;
+
+    void setXRunCount(int xRuns) noexcept;
+
+    /**
+     *  @brief  Sums counters of all threads. Leaves every counter as it is.
+     */
+    Snapshot getSnapshot() const;
+
+    /**
+     *  @brief Zeroes all counters.
+     */
+    void reset() noexcept;
+
+private:
+    static constexpr std::size_t maxThreads{8};
+
+    struct alignas(cacheLineSize) Counter {
+        std::atomic<juce::uint64> cycles{0};
+        std::atomic<juce::uint64> calls{0};
+        std::atomic<juce::uint64> maxCycles{0};
+    };
+
+    /**
+     *  @brief  Index of the calling thread's slot, assigned on first use.
+     */
+    static std::size_t getThreadSlot() noexcept;
+
+    std::array<std::array<Counter, numStages>, maxThreads> counters_;
+
+    alignas(cacheLineSize) std::atomic<double> callbackLoad_{0.0};
+    std::atomic<int> midiQueueDepth_{0};
+    std::atomic<int> xRuns_{0};
+
+    /// Cycle counter and wall clock at construction, used to calibrate
+    /// cycles per second.
+    const juce::uint64 startCycles_;
+    const double startSeconds_;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Telemetry)
+};
+
+/**
+ *
+ *  @class   ScopedStageTimer
+ *  @brief   Records the cycles spent in a scope to a stage counter. A null
+ *           telemetry pointer makes it a no-op.
+ *
+ */
+class ScopedStageTimer {
+public:
+    ScopedStageTimer(Telemetry *telemetry, Stage stage) noexcept
+        : telemetry_{telemetry}, stage_{stage},
+          start_{telemetry != nullptr ? Telemetry::readCycleCounter() : 0} {}
+
+    ~ScopedStageTimer() {
+        if (telemetry_ != nullptr) {
+            telemetry_->addSample(stage_,
+                                  Telemetry::readCycleCounter() - start_);
+        }
+    }
+
+private:
+    Telemetry *telemetry_;
+    const Stage stage_;
+    const juce::uint64 start_;
+
+    JUCE_DECLARE_NON_COPYABLE(ScopedStageTimer)
+};
+
+} // namespace anyMidi
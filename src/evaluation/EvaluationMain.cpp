@@ -0,0 +1,30 @@
+/**
+ *
+ *  @file      EvaluationMain.cpp
+ *  @brief     Console entry point running the offline evaluation as a test.
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#include <juce_core/juce_core.h>
+
+#include "../core/Evaluation.h"
+#include "../util/Globals.h"
+
+int main(int argc, char *argv[]) {
+    const juce::StringArray params{argv + 1, argc - 1};
+
+    // The baseline is relative to the working directory unless a path to it
+    // is given, as the test runner does.
+    const int baselineIndex = params.indexOf("--baseline");
+    const auto path = baselineIndex >= 0 && baselineIndex + 1 < params.size()
+                          ? params[baselineIndex + 1]
+                          : juce::String{anyMidi::EVALUATION_BASELINE_FILENAME};
+
+    const bool passed = anyMidi::runEvaluation(
+        juce::File::getCurrentWorkingDirectory().getChildFile(path),
+        params.contains("--update-baseline"));
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,204 @@
+/**
+ *
+ *  @file      PluginProcessor.cpp
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#include <algorithm>
+
+#include "PluginProcessor.h"
+
+namespace {
+const juce::String attackId{"attackThreshold"};
+const juce::String releaseId{"releaseThreshold"};
+const juce::String partialsId{"numPartials"};
+const juce::String lowCutId{"lowCutFrequency"};
+const juce::String mpeId{"mpe"};
+const juce::String incrementalId{"incrementalAnalysis"};
+
+/// Sample rate the pipeline is constructed with, before the host prepares.
+constexpr double initialSampleRate{48000.0};
+} // namespace
+
+anyMidi::PluginProcessor::PluginProcessor()
+    : juce::AudioProcessor{BusesProperties()
+                               .withInput("Input",
+                                          juce::AudioChannelSet::mono(), true)
+                               .withOutput("Output",
+                                           juce::AudioChannelSet::mono(),
+                                           true)},
+      pipeline_{std::make_unique<AnalysisPipeline>(initialSampleRate)},
+      pipelineSampleRate_{initialSampleRate},
+      parameters_{*this, nullptr, "Parameters", createParameterLayout()},
+      attackThreshold_{parameters_.getRawParameterValue(attackId)},
+      releaseThreshold_{parameters_.getRawParameterValue(releaseId)},
+      numPartials_{parameters_.getRawParameterValue(partialsId)},
+      lowCutFrequency_{parameters_.getRawParameterValue(lowCutId)},
+      mpe_{parameters_.getRawParameterValue(mpeId)},
+      incrementalAnalysis_{parameters_.getRawParameterValue(incrementalId)} {}
+
+juce::AudioProcessorValueTreeState::ParameterLayout
+anyMidi::PluginProcessor::createParameterLayout() const {
+    constexpr int maxPartials{10};
+    constexpr float minFrequency{20.0F};
+    constexpr float maxFrequency{1000.0F};
+
+    juce::AudioProcessorValueTreeState::ParameterLayout layout;
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{attackId, 1}, "Attack threshold",
+        juce::NormalisableRange<float>{0.0F, 1.0F},
+        static_cast<float>(pipeline_->getAttackThreshold())));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{releaseId, 1}, "Release threshold",
+        juce::NormalisableRange<float>{0.0F, 1.0F},
+        static_cast<float>(pipeline_->getReleaseThreshold())));
+    layout.add(std::make_unique<juce::AudioParameterInt>(
+        juce::ParameterID{partialsId, 1}, "Partials", 1, maxPartials,
+        pipeline_->getNumPartials()));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{lowCutId, 1}, "Low cut",
+        juce::NormalisableRange<float>{minFrequency, maxFrequency},
+        static_cast<float>(AnalysisPipeline::lowFilterFreq)));
+    layout.add(std::make_unique<juce::AudioParameterBool>(
+        juce::ParameterID{mpeId, 1}, "MPE output", pipeline_->isMpeEnabled()));
+    layout.add(std::make_unique<juce::AudioParameterBool>(
+        juce::ParameterID{incrementalId, 1}, "Reuse steady analysis",
+        pipeline_->isIncrementalAnalysisEnabled()));
+    return layout;
+}
+
+const juce::String anyMidi::PluginProcessor::getName() const { // NOLINT
+    return JucePlugin_Name;
+}
+
+void anyMidi::PluginProcessor::prepareToPlay(
+    double sampleRate, int maximumExpectedSamplesPerBlock) {
+    analysisBuffer_.setSize(1, maximumExpectedSamplesPerBlock);
+
+    // Room for a note off, note on and expression on every channel.
+    constexpr int bytesPerBlock{2048};
+    events_.ensureSize(bytesPerBlock);
+
+    if (sampleRate != pipelineSampleRate_) {
+        // Note offs from releaseResources() still wait in the old pipeline.
+        auto pipeline = std::make_unique<AnalysisPipeline>(sampleRate);
+        pipeline->takePendingEvents(*pipeline_);
+        pipeline_ = std::move(pipeline);
+        pipelineSampleRate_ = sampleRate;
+        resetAppliedParameters();
+    }
+    pipeline_->prepare(sampleRate);
+    setLatencySamples(pipeline_->getFFTSize());
+}
+
+void anyMidi::PluginProcessor::releaseResources() {
+    // There is no MIDI output, so the note offs go to the host with the next
+    // block.
+    pipeline_->release();
+}
+
+bool anyMidi::PluginProcessor::isBusesLayoutSupported(
+    const BusesLayout &layouts) const {
+    const auto input = layouts.getMainInputChannelSet();
+    return !input.isDisabled() && input == layouts.getMainOutputChannelSet() &&
+           input.size() <= 2;
+}
+
+void anyMidi::PluginProcessor::resetAppliedParameters() {
+    // Forces every parameter onto the pipeline at the next block.
+    appliedAttack_ = -1.0F;
+    appliedRelease_ = -1.0F;
+    appliedPartials_ = -1.0F;
+    appliedLowCut_ = -1.0F;
+    appliedMpe_ = -1.0F;
+    appliedIncremental_ = -1.0F;
+}
+
+void anyMidi::PluginProcessor::applyParameters() {
+    const float attack = attackThreshold_->load();
+    if (attack != appliedAttack_) {
+        pipeline_->setAttackThreshold(attack);
+        appliedAttack_ = attack;
+    }
+    const float release = releaseThreshold_->load();
+    if (release != appliedRelease_) {
+        pipeline_->setReleaseThreshold(release);
+        appliedRelease_ = release;
+    }
+    const float partials = numPartials_->load();
+    if (partials != appliedPartials_) {
+        pipeline_->setNumPartials(static_cast<int>(partials));
+        appliedPartials_ = partials;
+    }
+    const float lowCut = lowCutFrequency_->load();
+    if (lowCut != appliedLowCut_) {
+        pipeline_->setLowCutFrequency(lowCut);
+        appliedLowCut_ = lowCut;
+    }
+    const float mpe = mpe_->load();
+    if (mpe != appliedMpe_) {
+        pipeline_->setMpeEnabled(mpe >= 0.5F);
+        appliedMpe_ = mpe;
+    }
+    const float incremental = incrementalAnalysis_->load();
+    if (incremental != appliedIncremental_) {
+        pipeline_->setIncrementalAnalysis(incremental >= 0.5F);
+        appliedIncremental_ = incremental;
+    }
+}
+
+void anyMidi::PluginProcessor::processBlock(juce::AudioBuffer<float> &buffer,
+                                            juce::MidiBuffer &midiMessages) {
+    const juce::ScopedNoDenormals noDenormals;
+    applyParameters();
+
+    // Only notes go out, audio passes through.
+    midiMessages.clear();
+
+    const int numSamples = buffer.getNumSamples();
+    if (getTotalNumInputChannels() == 0 || numSamples == 0) {
+        return;
+    }
+
+    // Hosts may exceed the expected block size.
+    analysisBuffer_.setSize(1, numSamples, false, false, true);
+    analysisBuffer_.copyFrom(0, 0, buffer, 0, 0, numSamples);
+
+    events_.clear();
+    pipeline_->processBlock(analysisBuffer_.getWritePointer(0), numSamples,
+                           &events_);
+
+    // A frame completed by the block's last sample places its events just
+    // past the block, they are kept on its last sample.
+    for (const auto metadata : events_) {
+        midiMessages.addEvent(
+            metadata.getMessage(),
+            std::min(metadata.samplePosition, numSamples - 1));
+    }
+}
+
+juce::AudioProcessorEditor *anyMidi::PluginProcessor::createEditor() {
+    return new juce::GenericAudioProcessorEditor(*this); // NOLINT
+}
+
+void anyMidi::PluginProcessor::getStateInformation(
+    juce::MemoryBlock &destData) {
+    const auto xml = parameters_.copyState().createXml();
+    copyXmlToBinary(*xml, destData);
+}
+
+void anyMidi::PluginProcessor::setStateInformation(const void *data,
+                                                   int sizeInBytes) {
+    const auto xml = getXmlFromBinary(data, sizeInBytes);
+    if (xml != nullptr && xml->hasTagName(parameters_.state.getType())) {
+        parameters_.replaceState(juce::ValueTree::fromXml(*xml));
+    }
+}
+
+// This creates new instances of the plugin.
+juce::AudioProcessor *JUCE_CALLTYPE createPluginFilter() {
+    return new anyMidi::PluginProcessor(); // NOLINT
+}
@@ -0,0 +1,112 @@
+/**
+ *
+ *  @file      PluginProcessor.h
+ *  @brief     The analysis pipeline hosted as an audio to MIDI plugin.
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#pragma once
+
+#include <memory>
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+#include "../core/AnalysisPipeline.h"
+
+namespace anyMidi {
+
+/**
+ *
+ *  @class   PluginProcessor
+ *  @brief   Runs the first input channel through the analysis pipeline and
+ *           emits the detected notes as MIDI with sample accurate offsets
+ *           into the block. Audio is passed through untouched. The FFT frame
+ *           is reported as latency, so the host can line the notes up with
+ *           the audio that produced them.
+ *
+ */
+class PluginProcessor : public juce::AudioProcessor {
+public:
+    PluginProcessor();
+
+    void prepareToPlay(double sampleRate, int maximumExpectedSamplesPerBlock)
+        override;
+    void releaseResources() override;
+
+    bool isBusesLayoutSupported(const BusesLayout &layouts) const override;
+
+    void processBlock(juce::AudioBuffer<float> &buffer,
+                      juce::MidiBuffer &midiMessages) override;
+
+    juce::AudioProcessorEditor *createEditor() override;
+    bool hasEditor() const override { return true; }
+
+    const juce::String getName() const override; // NOLINT
+    bool acceptsMidi() const override { return false; }
+    bool producesMidi() const override { return true; }
+    bool isMidiEffect() const override { return false; }
+    double getTailLengthSeconds() const override { return 0.0; }
+
+    int getNumPrograms() override { return 1; }
+    int getCurrentProgram() override { return 0; }
+    void setCurrentProgram([[maybe_unused]] int index) override {}
+    const juce::String // NOLINT
+    getProgramName([[maybe_unused]] int index) override {
+        return {};
+    }
+    void changeProgramName([[maybe_unused]] int index,
+                           [[maybe_unused]] const juce::String &newName)
+        override {}
+
+    void getStateInformation(juce::MemoryBlock &destData) override;
+    void setStateInformation(const void *data, int sizeInBytes) override;
+
+private:
+    /**
+     *  @brief Parameters with the pipeline's settings as defaults.
+     */
+    juce::AudioProcessorValueTreeState::ParameterLayout
+    createParameterLayout() const;
+
+    void resetAppliedParameters();
+
+    /**
+     *  @brief Passes changed parameter values on to the pipeline. Called at
+     *         the start of every block, so they change at block boundaries
+     *         like in the standalone app.
+     */
+    void applyParameters();
+
+    /// Rebuilt when the host changes sample rate, since the FFT bins are
+    /// laid out for the rate the pipeline was constructed with.
+    std::unique_ptr<AnalysisPipeline> pipeline_;
+    double pipelineSampleRate_;
+    juce::AudioProcessorValueTreeState parameters_;
+
+    std::atomic<float> *attackThreshold_;
+    std::atomic<float> *releaseThreshold_;
+    std::atomic<float> *numPartials_;
+    std::atomic<float> *lowCutFrequency_;
+    std::atomic<float> *mpe_;
+    std::atomic<float> *incrementalAnalysis_;
+
+    /// Values last passed to the pipeline.
+    float appliedAttack_{-1.0F};
+    float appliedRelease_{-1.0F};
+    float appliedPartials_{-1.0F};
+    float appliedLowCut_{-1.0F};
+    float appliedMpe_{-1.0F};
+    float appliedIncremental_{-1.0F};
+
+    /// Copy of the analysed channel, since the pipeline filters in place.
+    juce::AudioBuffer<float> analysisBuffer_;
+    /// Events of the block, placed by offset into it.
+    juce::MidiBuffer events_;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PluginProcessor)
+};
+
+} // namespace anyMidi
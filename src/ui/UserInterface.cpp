@@ -13,11 +13,13 @@
 
 #include "../core/AudioProcessor.h"
 #include "../util/Globals.h"
+#include "../util/Logger.h"
 #include "UserInterface.h"
 
 anyMidi::TabbedComp::TabbedComp(const juce::ValueTree &v)
     : TabbedComponent(juce::TabbedButtonBar::TabsAtTop), tree_{v},
-      audioSetupPage_{v}, appSettingsPage_{v}, debugPage_{v} {
+      audioSetupPage_{v}, appSettingsPage_{v}, visualizerPage_{v},
+      debugPage_{v} {
     // audioSetupViewport.setViewedComponent(&audioSetupPage, false);
     // addAndMakeVisible(audioSetupPage);
 
@@ -26,19 +28,38 @@ anyMidi::TabbedComp::TabbedComp(const juce::ValueTree &v)
 
     addTab("App Settings", color, &appSettingsPage_, true);
     addTab("Audio Settings", color, &audioSetupPage_, true);
+    addTab("Visualizer", color, &visualizerPage_, true);
     addTab("Debug", color, &debugPage_, true);
 
     // audioSetupViewport.setBounds(getLocalBounds());
     // audioSetupPage.setBounds(0, 0, 400, 290);
 }
 
-anyMidi::AudioSetupPage::AudioSetupPage(const juce::ValueTree &v) : tree_{v} {
-    // Fetch audio device manager from the value tree.
+anyMidi::AudioSetupPage::AudioSetupPage(const juce::ValueTree &v)
+    : tree_{v} {
+    audioProcNode_ = tree_.getParent().getChildWithName(anyMidi::AUDIO_PROC_ID);
+    openingLabel_.setText("Opening audio device...",
+                          juce::dontSendNotification);
+    openingLabel_.setJustificationType(juce::Justification::centred);
+    addAndMakeVisible(openingLabel_);
+
+    audioProcNode_.addListener(this);
+    createDeviceSelector();
+}
+
+anyMidi::AudioSetupPage::~AudioSetupPage() {
+    // Device settings are saved by the audio processor whenever they change.
+    audioProcNode_.removeListener(this);
+}
+
+void anyMidi::AudioSetupPage::createDeviceSelector() {
+    // Fetch audio device manager from the value tree. It is only added once
+    // the device has been opened.
     auto *deviceManager = dynamic_cast<anyMidi::AudioDeviceManagerRCO *>(
-        tree_.getParent()
-            .getChildWithName(anyMidi::AUDIO_PROC_ID)
-            .getProperty(anyMidi::DEVICE_MANAGER_ID)
-            .getObject());
+        audioProcNode_.getProperty(anyMidi::DEVICE_MANAGER_ID).getObject());
+    if (deviceManager == nullptr || audioSetupComp_ != nullptr) {
+        return;
+    }
 
     audioSetupComp_ = std::make_unique<juce::AudioDeviceSelectorComponent>(
         *deviceManager,
@@ -52,23 +73,24 @@ anyMidi::AudioSetupPage::AudioSetupPage(const juce::ValueTree &v) : tree_{v} {
         false  // hide advanced options?
     );
 
+    openingLabel_.setVisible(false);
     addAndMakeVisible(*audioSetupComp_);
+    resized();
 }
 
-anyMidi::AudioSetupPage::~AudioSetupPage() {
-    auto audioDeviceSettings = audioSetupComp_->deviceManager.createStateXml();
-
-    if (audioDeviceSettings != nullptr) {
-        // Writes user settings to XML file for storage.
-        const juce::File settingsFileName =
-            juce::File::getCurrentWorkingDirectory().getChildFile(
-                anyMidi::AUDIO_SETTINGS_FILENAME);
-        settingsFileName.replaceWithText(audioDeviceSettings->toString());
+void anyMidi::AudioSetupPage::resized() {
+    openingLabel_.setBounds(getLocalBounds());
+    if (audioSetupComp_ != nullptr) {
+        audioSetupComp_->setBounds(getLocalBounds().withWidth(getWidth()));
     }
 }
 
-void anyMidi::AudioSetupPage::resized() {
-    audioSetupComp_->setBounds(getLocalBounds().withWidth(getWidth()));
+void anyMidi::AudioSetupPage::valueTreePropertyChanged(
+    [[maybe_unused]] juce::ValueTree &treeWhosePropertyHasChanged,
+    const juce::Identifier &property) {
+    if (property == anyMidi::DEVICE_MANAGER_ID) {
+        createDeviceSelector();
+    }
 }
 
 anyMidi::AppSettingsPage::AppSettingsPage(const juce::ValueTree &v) : tree_{v} {
@@ -147,6 +169,30 @@ anyMidi::AppSettingsPage::AppSettingsPage(const juce::ValueTree &v) : tree_{v} {
                           nullptr);
     };
 
+    // Smoothing slider, in frames of lag
+    constexpr double smoothingMin{0};
+    constexpr double smoothingMax{NoteSmoother::maxLag};
+    constexpr double smoothingIncr{1};
+    addAndMakeVisible(smoothingSlider_);
+    smoothingSlider_.setRange(smoothingMin, smoothingMax, smoothingIncr);
+    smoothingSlider_.setSliderStyle(juce::Slider::LinearBarVertical);
+    smoothingSlider_.setColour(juce::Slider::ColourIds::trackColourId,
+                               juce::Colours::transparentWhite);
+    smoothingSlider_.setVelocityBasedMode(true);
+    smoothingSlider_.setVelocityModeParameters(sliderSense, sliderVelThresh,
+                                               sliderVelOffset, false);
+
+    if (tree_.hasProperty(anyMidi::SMOOTHING_LAG_ID)) {
+        smoothingSlider_.setValue(tree_.getProperty(anyMidi::SMOOTHING_LAG_ID));
+    }
+
+    // Callback
+    smoothingSlider_.onValueChange = [this] {
+        tree_.setProperty(anyMidi::SMOOTHING_LAG_ID,
+                          static_cast<int>(smoothingSlider_.getValue()),
+                          nullptr);
+    };
+
     // Filter sliders
     constexpr int filterSliderWidth{300};
     constexpr int filterSliderHeight{1000};
@@ -245,6 +291,49 @@ anyMidi::AppSettingsPage::AppSettingsPage(const juce::ValueTree &v) : tree_{v} {
                           winMethodList_.getSelectedId() - 1, nullptr);
     };
 
+    // MPE output, with pitch bend and pressure per note
+    addAndMakeVisible(mpeToggle_);
+    mpeToggle_.setToggleState(tree_.getProperty(anyMidi::MPE_ID),
+                              juce::dontSendNotification);
+
+    mpeToggle_.onClick = [this] {
+        tree_.setProperty(anyMidi::MPE_ID, mpeToggle_.getToggleState(),
+                          nullptr);
+    };
+
+    // Lower latency for high notes, with frames fitted to the note
+    addAndMakeVisible(adaptiveWindowToggle_);
+    adaptiveWindowToggle_.setToggleState(
+        tree_.getProperty(anyMidi::ADAPTIVE_WINDOW_ID),
+        juce::dontSendNotification);
+
+    adaptiveWindowToggle_.onClick = [this] {
+        tree_.setProperty(anyMidi::ADAPTIVE_WINDOW_ID,
+                          adaptiveWindowToggle_.getToggleState(), nullptr);
+    };
+
+    // Fewer full analyses while a note sustains
+    addAndMakeVisible(incrementalToggle_);
+    incrementalToggle_.setToggleState(
+        tree_.getProperty(anyMidi::INCREMENTAL_ANALYSIS_ID),
+        juce::dontSendNotification);
+
+    incrementalToggle_.onClick = [this] {
+        tree_.setProperty(anyMidi::INCREMENTAL_ANALYSIS_ID,
+                          incrementalToggle_.getToggleState(), nullptr);
+    };
+
+    // Release and expression of the sounding note between frames
+    addAndMakeVisible(slidingToggle_);
+    slidingToggle_.setToggleState(
+        tree_.getProperty(anyMidi::SLIDING_TRACKING_ID),
+        juce::dontSendNotification);
+
+    slidingToggle_.onClick = [this] {
+        tree_.setProperty(anyMidi::SLIDING_TRACKING_ID,
+                          slidingToggle_.getToggleState(), nullptr);
+    };
+
     // Attack threshold label
     addAndMakeVisible(attThreshLabel_);
     attThreshLabel_.setText("Attack thresh.", juce::dontSendNotification);
@@ -264,6 +353,10 @@ anyMidi::AppSettingsPage::AppSettingsPage(const juce::ValueTree &v) : tree_{v} {
     // Windowing method label
     addAndMakeVisible(winMethodLabel_);
     winMethodLabel_.setText("Window", juce::dontSendNotification);
+
+    // Smoothing label
+    addAndMakeVisible(smoothingLabel_);
+    smoothingLabel_.setText("Smoothing", juce::dontSendNotification);
 }
 
 void anyMidi::AppSettingsPage::resized() {
@@ -274,6 +367,11 @@ void anyMidi::AppSettingsPage::resized() {
     constexpr int yOffsetLevel3{6};
     constexpr float yOffsetLevel4{7.2};
     constexpr int yOffsetLevel5{9};
+    constexpr float yOffsetLevel6{10.5};
+    constexpr float yOffsetLevel7{12.0};
+    constexpr float yOffsetLevel8{13.5};
+    constexpr float yOffsetLevel9{15.0};
+    constexpr float yOffsetLevel10{16.5};
 
     attThreshLabel_.setBounds(labelPad, yPad, elementWidth, elementHeight);
     relThreshLabel_.setBounds(labelPad, yPad + yOffsetLevel1 * elementHeight,
@@ -284,6 +382,9 @@ void anyMidi::AppSettingsPage::resized() {
                            elementWidth, elementHeight);
     winMethodLabel_.setBounds(labelPad, yPad + yOffsetLevel5 * elementHeight,
                               elementWidth * 2, elementHeight);
+    smoothingLabel_.setBounds(
+        labelPad, yPad + static_cast<int>(yOffsetLevel8 * elementHeight),
+        elementWidth, elementHeight);
 
     attThreshSlider_.setBounds(valPad + elementWidth / 2, yPad, elementWidth,
                                elementHeight);
@@ -303,6 +404,22 @@ void anyMidi::AppSettingsPage::resized() {
                          elementWidth, elementHeight);
     winMethodList_.setBounds(valPad, yPad + yOffsetLevel5 * elementHeight,
                              elementWidth * 2, elementHeight);
+    mpeToggle_.setBounds(valPad,
+                         yPad + static_cast<int>(yOffsetLevel6 * elementHeight),
+                         elementWidth * 2, elementHeight);
+    adaptiveWindowToggle_.setBounds(
+        valPad, yPad + static_cast<int>(yOffsetLevel7 * elementHeight),
+        elementWidth * 2, elementHeight);
+    smoothingSlider_.setBounds(
+        valPad + elementWidth / 2,
+        yPad + static_cast<int>(yOffsetLevel8 * elementHeight), elementWidth,
+        elementHeight);
+    incrementalToggle_.setBounds(
+        valPad, yPad + static_cast<int>(yOffsetLevel9 * elementHeight),
+        elementWidth * 2, elementHeight);
+    slidingToggle_.setBounds(
+        valPad, yPad + static_cast<int>(yOffsetLevel10 * elementHeight),
+        elementWidth * 2, elementHeight);
 }
 
 anyMidi::DebugPage::DebugPage(const juce::ValueTree &v) : tree_{v} {
@@ -334,6 +451,23 @@ anyMidi::DebugPage::DebugPage(const juce::ValueTree &v) : tree_{v} {
     clearOutput_.setButtonText("Clear output");
     clearOutput_.onClick = [this] { outputBox_.clear(); };
 
+    addAndMakeVisible(telemetryTable_);
+    telemetryTable_.setModel(&telemetryModel_);
+    telemetryTable_.setHeaderHeight(elementHeight);
+    telemetryTable_.setRowHeight(elementHeight);
+    constexpr int stageColumnWidth{140};
+    constexpr int valueColumnWidth{70};
+    auto &header = telemetryTable_.getHeader();
+    header.addColumn("Stage", TelemetryTableModel::StageColumn,
+                     stageColumnWidth);
+    header.addColumn("Calls", TelemetryTableModel::CallsColumn,
+                     valueColumnWidth);
+    header.addColumn("Mean us", TelemetryTableModel::MeanColumn,
+                     valueColumnWidth);
+    header.addColumn("Max us", TelemetryTableModel::MaxColumn,
+                     valueColumnWidth);
+    startTimerHz(telemetryRefreshRateHz);
+
     addAndMakeVisible(writeToXml_);
     writeToXml_.setButtonText("Write state to file");
     writeToXml_.onClick = [this] {
@@ -357,6 +491,20 @@ anyMidi::DebugPage::DebugPage(const juce::ValueTree &v) : tree_{v} {
                                       nullptr);
         }
 
+        // Telemetry is an RCO as well, and is exported to its own files.
+        const Telemetry::Ptr telemetry = getTelemetry();
+        const auto spectrum =
+            audioProcNode.getProperty(anyMidi::SPECTRUM_ID);
+        audioProcNode.setProperty(anyMidi::SPECTRUM_ID,
+                                  "Spectrum snapshots are not serialized.",
+                                  nullptr);
+        audioProcNode.setProperty(anyMidi::TELEMETRY_ID,
+                                  telemetry != nullptr
+                                      ? "Telemetry exists, exported to "
+                                        "separate files."
+                                      : "No telemetry found.",
+                                  nullptr);
+
         auto xml = tree_.getRoot().toXmlString();
 
         // This holy mess to get a simple timestamp.
@@ -377,31 +525,91 @@ anyMidi::DebugPage::DebugPage(const juce::ValueTree &v) : tree_{v} {
         const auto file =
             juce::File::getCurrentWorkingDirectory().getChildFile(filename);
         if (file.replaceWithText(xml)) {
-            anyMidi::log(tree_,
-                         std::format("State successfully written to {}",
-                                     file.getFullPathName().toStdString()));
+            anyMidi::log(LogLevel::Info, "State successfully written to {}",
+                         file.getFullPathName().toRawUTF8());
         } else {
-            anyMidi::log(tree_, "Failed to write state to file.");
+            anyMidi::log(LogLevel::Error, "Failed to write state to file.");
+        }
+
+        if (telemetry != nullptr) {
+            const auto snapshot = telemetry->getSnapshot();
+            const auto stem = "anyMidi_telemetry_" + timestamp.str();
+            const auto dir = juce::File::getCurrentWorkingDirectory();
+            const auto csvFile = dir.getChildFile(stem + ".csv");
+            const auto jsonFile = dir.getChildFile(stem + ".json");
+
+            if (csvFile.replaceWithText(snapshot.toCsv()) &&
+                jsonFile.replaceWithText(snapshot.toJson())) {
+                anyMidi::log(LogLevel::Info,
+                             "Telemetry successfully written to {}.csv/.json",
+                             dir.getChildFile(stem)
+                                 .getFullPathName()
+                                 .toRawUTF8());
+            } else {
+                anyMidi::log(LogLevel::Error,
+                             "Failed to write telemetry to file.");
+            }
         }
 
         // Reset the altered nodes.
         audioProcNode.setProperty(anyMidi::DEVICE_MANAGER_ID, deviceManager,
                                   nullptr);
+        audioProcNode.setProperty(anyMidi::TELEMETRY_ID, telemetry.get(),
+                                  nullptr);
+        audioProcNode.setProperty(anyMidi::SPECTRUM_ID, spectrum, nullptr);
     };
 }
 
 void anyMidi::DebugPage::resized() {
     const int outputWidth = getWidth() - 2 * xPad;
-    const int outputHeight = (getHeight() / 3) * 2;
-    constexpr float yPadScale{1.5};
+    const int outputHeight = getHeight() / 4;
+    constexpr int innerPad{5};
+
+    const int buttonY = getHeight() - buttonHeight - innerPad;
+    const int tableY = yPad + outputHeight + innerPad;
 
     outputBox_.setBounds(xPad, yPad, outputWidth, outputHeight);
+    telemetryTable_.setBounds(xPad, tableY, outputWidth,
+                              buttonY - tableY - innerPad);
     clearOutput_.setBounds(xPad + (outputWidth / 2 - elementWidth) / 2,
-                           (int)(yPadScale * yPad) + outputHeight, buttonWidth,
-                           buttonHeight);
-    writeToXml_.setBounds(
-        xPad + outputWidth / 2 + (outputWidth / 2 - elementWidth) / 2,
-        (int)(yPadScale * yPad) + outputHeight, buttonWidth, buttonHeight);
+                           buttonY, buttonWidth, buttonHeight);
+    writeToXml_.setBounds(xPad + outputWidth / 2 +
+                              (outputWidth / 2 - elementWidth) / 2,
+                          buttonY, buttonWidth, buttonHeight);
+}
+
+anyMidi::Telemetry *anyMidi::DebugPage::getTelemetry() const {
+    return dynamic_cast<anyMidi::Telemetry *>(
+        tree_.getParent()
+            .getChildWithName(anyMidi::AUDIO_PROC_ID)
+            .getProperty(anyMidi::TELEMETRY_ID)
+            .getObject());
+}
+
+void anyMidi::DebugPage::timerCallback() {
+    auto *telemetry = getTelemetry();
+    if (telemetry == nullptr || !isShowing()) {
+        return;
+    }
+
+    // xruns are only known by the device, so they're fetched here rather than
+    // on the audio thread.
+    auto *deviceManager = dynamic_cast<anyMidi::AudioDeviceManagerRCO *>(
+        tree_.getParent()
+            .getChildWithName(anyMidi::AUDIO_PROC_ID)
+            .getProperty(anyMidi::DEVICE_MANAGER_ID)
+            .getObject());
+    if (deviceManager != nullptr) {
+        if (auto *device = deviceManager->getCurrentAudioDevice()) {
+            telemetry->setXRunCount(device->getXRunCount());
+        }
+    }
+
+    telemetryModel_.setSnapshot(telemetry->getSnapshot());
+    // Each refresh shows the deepest MIDI queue since the previous one.
+    telemetry->resetMidiQueueDepth();
+    telemetryTable_.updateContent();
+    telemetryTable_.repaint();
 }
 
 void anyMidi::DebugPage::valueTreePropertyChanged(
@@ -419,6 +627,254 @@ void anyMidi::DebugPage::valueTreePropertyChanged(
     }
 }
 
+anyMidi::VisualizerPage::VisualizerPage(const juce::ValueTree &v)
+    : tree_{v},
+      publisher_{dynamic_cast<anyMidi::SpectrumPublisher *>(
+          tree_.getParent()
+              .getChildWithName(anyMidi::AUDIO_PROC_ID)
+              .getProperty(anyMidi::SPECTRUM_ID)
+              .getObject())} {
+    setOpaque(true);
+    startTimerHz(frameRateHz);
+}
+
+void anyMidi::VisualizerPage::resized() {
+    plotArea_ = getLocalBounds().reduced(xPad, 0).withTrimmedTop(yPad);
+    noteArea_ = plotArea_.removeFromBottom(noteLabelHeight);
+    renderBackground();
+
+    if (publisher_ != nullptr) {
+        updatePaths(publisher_->getReadBuffer());
+    }
+}
+
+void anyMidi::VisualizerPage::renderBackground() {
+    if (getWidth() <= 0 || getHeight() <= 0) {
+        return;
+    }
+
+    background_ = juce::Image(juce::Image::RGB, getWidth(), getHeight(), true);
+    juce::Graphics g{background_};
+
+    g.fillAll(getLookAndFeel().findColour(
+        juce::ResizableWindow::backgroundColourId));
+    g.setColour(
+        getLookAndFeel().findColour(juce::TextEditor::backgroundColourId));
+    g.fillRect(plotArea_);
+
+    // Horizontal lines every 20 dB.
+    constexpr float gridStep{20.0F};
+    g.setColour(getLookAndFeel()
+                    .findColour(juce::TextEditor::outlineColourId)
+                    .withAlpha(0.5F));
+    for (float db = 0.0F; db > minDecibels; db -= gridStep) {
+        g.drawHorizontalLine(
+            static_cast<int>(amplitudeToY(juce::Decibels::decibelsToGain(db))),
+            static_cast<float>(plotArea_.getX()),
+            static_cast<float>(plotArea_.getRight()));
+    }
+}
+
+float anyMidi::VisualizerPage::binToX(double bin, std::size_t numBins) const {
+    // Logarithmic frequency axis, as notes are spaced logarithmically.
+    if (bin < 1.0 || numBins < 2) {
+        return static_cast<float>(plotArea_.getX());
+    }
+    const double position =
+        std::log(bin) / std::log(static_cast<double>(numBins));
+    return static_cast<float>(plotArea_.getX() +
+                              position * plotArea_.getWidth());
+}
+
+float anyMidi::VisualizerPage::amplitudeToY(float amplitude) const {
+    const float db = juce::Decibels::gainToDecibels(amplitude, minDecibels);
+    return juce::jmap(db, minDecibels, 0.0F,
+                      static_cast<float>(plotArea_.getBottom()),
+                      static_cast<float>(plotArea_.getY()));
+}
+
+void anyMidi::VisualizerPage::updatePaths(const SpectrumSnapshot &snapshot) {
+    spectrumPath_.clear();
+    partialPath_.clear();
+
+    if (snapshot.numBins < 2 || plotArea_.isEmpty()) {
+        return;
+    }
+
+    // Amplitudes are normalised by the FFT size, the same way as in the
+    // harmonic analysis. The snapshot holds the bins up to half of it.
+    const auto scale = 1.0F / static_cast<float>(2 * (snapshot.numBins - 1));
+
+    // Collapses all bins falling on the same pixel column into their max, so
+    // the path never has more points than the plot is wide.
+    int column{-1};
+    float columnMax{0.0F};
+    const auto addColumn = [&] {
+        const auto x = static_cast<float>(column);
+        const auto y = amplitudeToY(columnMax * scale);
+        if (spectrumPath_.isEmpty()) {
+            spectrumPath_.startNewSubPath(x, y);
+        } else {
+            spectrumPath_.lineTo(x, y);
+        }
+    };
+
+    for (std::size_t bin = 1; bin < snapshot.numBins; ++bin) {
+        const auto x = static_cast<int>(
+            binToX(static_cast<double>(bin), snapshot.numBins));
+        if (x != column) {
+            if (column >= 0) {
+                addColumn();
+            }
+            column = x;
+            columnMax = 0.0F;
+        }
+        columnMax = std::max(columnMax, snapshot.magnitudes[bin]);
+    }
+    addColumn();
+
+    for (std::size_t i = 0; i < snapshot.numPartials; ++i) {
+        if (snapshot.binWidth <= 0.0) {
+            break;
+        }
+        const float x = binToX(snapshot.partialFrequencies[i] /
+                                   snapshot.binWidth,
+                               snapshot.numBins);
+        partialPath_.startNewSubPath(x,
+                                     static_cast<float>(plotArea_.getBottom()));
+        partialPath_.lineTo(x, amplitudeToY(snapshot.partialAmplitudes[i]));
+    }
+}
+
+void anyMidi::VisualizerPage::timerCallback() {
+    if (publisher_ == nullptr || !isShowing() || !publisher_->update()) {
+        return;
+    }
+
+    const auto &snapshot = publisher_->getReadBuffer();
+    if (snapshot.frame == lastFrame_) {
+        return;
+    }
+    lastFrame_ = snapshot.frame;
+
+    updatePaths(snapshot);
+    repaint(plotArea_);
+
+    juce::String text{"-"};
+    if (snapshot.note >= 0) {
+        // Analysed note values are one octave below the MIDI output, see
+        // MidiProcessor::createMidiMsg().
+        constexpr int octave{12};
+        constexpr int middleC{4};
+        constexpr int decimals{3};
+        text = juce::MidiMessage::getMidiNoteName(snapshot.note + octave, true,
+                                                  true, middleC) +
+               "  amp " + juce::String(snapshot.amplitude, decimals) +
+               (snapshot.noteOn ? "  [on]" : "");
+    }
+    if (text != noteText_) {
+        noteText_ = text;
+        repaint(noteArea_);
+    }
+}
+
+void anyMidi::VisualizerPage::paint(juce::Graphics &g) {
+    if (background_.isValid()) {
+        g.drawImageAt(background_, 0, 0);
+    } else {
+        g.fillAll(getLookAndFeel().findColour(
+            juce::ResizableWindow::backgroundColourId));
+    }
+
+    const auto &lf = getLookAndFeel();
+    g.setColour(lf.findColour(juce::TextEditor::textColourId));
+    g.strokePath(spectrumPath_, juce::PathStrokeType(1.0F));
+
+    g.setColour(lf.findColour(juce::Slider::thumbColourId));
+    constexpr float partialThickness{2.0F};
+    g.strokePath(partialPath_, juce::PathStrokeType(partialThickness));
+
+    g.setColour(lf.findColour(juce::Label::textColourId));
+    g.drawText(noteText_, noteArea_, juce::Justification::centredLeft, true);
+}
+
+void anyMidi::TelemetryTableModel::setSnapshot(
+    const Telemetry::Snapshot &snapshot) {
+    snapshot_ = snapshot;
+}
+
+int anyMidi::TelemetryTableModel::getNumRows() {
+    return static_cast<int>(numStages) + numSummaryRows;
+}
+
+void anyMidi::TelemetryTableModel::paintRowBackground(
+    juce::Graphics &g, [[maybe_unused]] int rowNumber,
+    [[maybe_unused]] int width, [[maybe_unused]] int height,
+    [[maybe_unused]] bool rowIsSelected) {
+    g.fillAll(owner_.getLookAndFeel().findColour(
+        juce::TextEditor::backgroundColourId));
+}
+
+void anyMidi::TelemetryTableModel::paintCell(
+    juce::Graphics &g, int rowNumber, int columnId, int width, int height,
+    [[maybe_unused]] bool rowIsSelected) {
+    constexpr int textPad{2};
+    g.setColour(owner_.getLookAndFeel().findColour(
+        juce::TextEditor::textColourId));
+    g.drawText(getCellText(rowNumber, columnId), textPad, 0,
+               width - 2 * textPad, height,
+               columnId == StageColumn ? juce::Justification::centredLeft
+                                       : juce::Justification::centredRight,
+               true);
+}
+
+juce::String anyMidi::TelemetryTableModel::getCellText(int rowNumber,
+                                                       int columnId) const {
+    constexpr int decimals{1};
+    const auto row = static_cast<std::size_t>(rowNumber);
+
+    if (row < numStages) {
+        const auto &stats = snapshot_.stages[row];
+        switch (columnId) {
+        case StageColumn:
+            return getStageName(static_cast<Stage>(row));
+        case CallsColumn:
+            return juce::String(stats.calls);
+        case MeanColumn:
+            return stats.calls > 0
+                       ? juce::String(snapshot_.toMicroseconds(stats.cycles) /
+                                          static_cast<double>(stats.calls),
+                                      decimals)
+                       : juce::String("-");
+        case MaxColumn:
+            return juce::String(snapshot_.toMicroseconds(stats.maxCycles),
+                                decimals);
+        default:
+            return {};
+        }
+    }
+
+    // Summary rows only fill the first two columns.
+    const auto summaryRow = row - numStages;
+    if (columnId == StageColumn) {
+        constexpr std::array<const char *, numSummaryRows> names{
+            "Callback load %", "XRuns", "MIDI queue depth"};
+        return names.at(summaryRow);
+    }
+    if (columnId == CallsColumn) {
+        constexpr double percent{100.0};
+        switch (summaryRow) {
+        case 0:
+            return juce::String(snapshot_.callbackLoad * percent, decimals);
+        case 1:
+            return juce::String(snapshot_.xRuns);
+        default:
+            return juce::String(snapshot_.midiQueueDepth);
+        }
+    }
+    return {};
+}
+
 anyMidi::TrayIcon::TrayIcon(juce::DocumentWindow *mainWindow)
     : mainWindow{mainWindow} {
     const juce::Image icon = juce::ImageCache::getFromMemory(
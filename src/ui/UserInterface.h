@@ -16,6 +16,8 @@
 #include <juce_gui_basics/juce_gui_basics.h>
 #include <juce_gui_extra/juce_gui_extra.h>
 
+#include "../core/SpectrumSnapshot.h"
+#include "../core/Telemetry.h"
 #include "../util/Globals.h"
 #include "CustomLookAndFeel.h"
 
@@ -37,19 +39,33 @@ constexpr int labelPad = xPad;
  *
  *  @class   AudioSetupPage
  *  @brief   GUI wrapper around the JUCE AudioDeviceSelectorComponent,
- *           connecting it with the rest of the GUI and the ValueTree.
+ *           connecting it with the rest of the GUI and the ValueTree. Shows a
+ *           placeholder until the audio device has been opened in the
+ *           background.
  *
  */
-class AudioSetupPage : public juce::Component {
+class AudioSetupPage : public juce::Component,
+                       public juce::ValueTree::Listener {
 public:
     explicit AudioSetupPage(const juce::ValueTree &v);
     ~AudioSetupPage() override;
 
     void resized() override;
 
+    void valueTreePropertyChanged(juce::ValueTree &treeWhosePropertyHasChanged,
+                                  const juce::Identifier &property) override;
+
 private:
+    /**
+     *  @brief Creates the device selector once the device manager is
+     *         published in the ValueTree.
+     */
+    void createDeviceSelector();
+
     std::unique_ptr<juce::AudioDeviceSelectorComponent> audioSetupComp_;
+    juce::Label openingLabel_;
     juce::ValueTree tree_;
+    juce::ValueTree audioProcNode_;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioSetupPage)
 };
@@ -75,30 +91,76 @@ private:
     juce::Slider attThreshSlider_;
     juce::Slider relThreshSlider_;
     juce::Slider partialsSlider_;
+    juce::Slider smoothingSlider_;
     juce::Slider filterSlider_;
     juce::TextEditor loCutFreq_;
     juce::TextEditor hiCutFreq_;
     juce::ComboBox winMethodList_;
+    juce::ToggleButton mpeToggle_{"MPE output"};
+    juce::ToggleButton adaptiveWindowToggle_{"Shorter windows for high notes"};
+    juce::ToggleButton incrementalToggle_{"Reuse analysis of steady notes"};
+    juce::ToggleButton slidingToggle_{"Track notes between frames"};
 
     juce::Label attThreshLabel_;
     juce::Label relThreshLabel_;
     juce::Label partialsLabel_;
     juce::Label filterLabel_;
     juce::Label winMethodLabel_;
+    juce::Label smoothingLabel_;
 
     juce::ValueTree tree_;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AppSettingsPage)
 };
 
+/**
+ *
+ *  @class   TelemetryTableModel
+ *  @brief   Table contents of the per stage timings and load statistics shown
+ *           on the debug page.
+ *
+ */
+class TelemetryTableModel : public juce::TableListBoxModel {
+public:
+    enum ColumnId { StageColumn = 1, CallsColumn, MeanColumn, MaxColumn };
+
+    /**
+     *  @param owner - Component whose look and feel the cells are drawn with.
+     */
+    explicit TelemetryTableModel(const juce::Component &owner)
+        : owner_{owner} {}
+
+    void setSnapshot(const Telemetry::Snapshot &snapshot);
+
+    int getNumRows() override;
+
+    void paintRowBackground(juce::Graphics &g, int rowNumber, int width,
+                            int height, bool rowIsSelected) override;
+
+    void paintCell(juce::Graphics &g, int rowNumber, int columnId, int width,
+                   int height, bool rowIsSelected) override;
+
+private:
+    /// Rows after the stages: callback load, xruns and MIDI queue depth.
+    static constexpr int numSummaryRows{3};
+
+    juce::String getCellText(int rowNumber, int columnId) const;
+
+    const juce::Component &owner_;
+    Telemetry::Snapshot snapshot_;
+};
+
 /**
  *
  *  @class   DebugPage
- *  @brief   GUI for debugging purposes, providing logging functionality
- *           and access to the ValueTree serialization.
+ *  @brief   GUI for debugging purposes, providing logging functionality,
+ *           live pipeline telemetry and access to the ValueTree
+ *           serialization.
  *
  */
-class DebugPage : public juce::Component, public juce::ValueTree::Listener {
+class DebugPage : public juce::Component,
+                  public juce::ValueTree::Listener,
+                  private juce::Timer {
 public:
     explicit DebugPage(const juce::ValueTree &v);
     ~DebugPage() override = default;
@@ -109,16 +171,91 @@ public:
                                   const juce::Identifier &property) override;
 
 private:
+    static constexpr int telemetryRefreshRateHz{4};
+
+    /**
+     *  @brief Publishes a fresh telemetry snapshot to the table.
+     */
+    void timerCallback() override;
+
+    /**
+     *  @brief  Fetches the telemetry object shared by the audio processor.
+     *  @retval  - Telemetry, or nullptr if the audio processor has none.
+     */
+    Telemetry *getTelemetry() const;
+
     juce::ValueTree tree_;
     juce::TextEditor outputBox_;
     juce::TextButton clearOutput_;
     juce::TextButton writeToXml_;
 
+    TelemetryTableModel telemetryModel_{*this};
+    juce::TableListBox telemetryTable_;
+
     juce::Label outputBoxLabel_;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DebugPage)
 };
 
+/**
+ *
+ *  @class   VisualizerPage
+ *  @brief   Live view of the magnitude spectrum, the partials chosen by the
+ *           harmonic analysis and the decided note. Reads snapshots published
+ *           by the audio processor at a capped frame rate and only repaints
+ *           the regions that changed.
+ *
+ */
+class VisualizerPage : public juce::Component, private juce::Timer {
+public:
+    explicit VisualizerPage(const juce::ValueTree &v);
+    ~VisualizerPage() override = default;
+
+    void paint(juce::Graphics &g) override;
+
+    void resized() override;
+
+private:
+    static constexpr int frameRateHz{30};
+    static constexpr float minDecibels{-100.0F};
+    static constexpr int noteLabelHeight{elementHeight};
+
+    /**
+     *  @brief Takes the latest snapshot, rebuilding cached paths and
+     *         repainting only what changed.
+     */
+    void timerCallback() override;
+
+    /**
+     *  @brief Rebuilds the spectrum path and partial markers from the current
+     *         snapshot.
+     */
+    void updatePaths(const SpectrumSnapshot &snapshot);
+
+    /**
+     *  @brief Draws the axis grid into the cached background image.
+     */
+    void renderBackground();
+
+    float binToX(double bin, std::size_t numBins) const;
+    float amplitudeToY(float amplitude) const;
+
+    juce::ValueTree tree_;
+    SpectrumPublisher::Ptr publisher_;
+
+    juce::Rectangle<int> plotArea_;
+    juce::Rectangle<int> noteArea_;
+
+    juce::Image background_;
+    juce::Path spectrumPath_;
+    juce::Path partialPath_;
+
+    juce::uint32 lastFrame_{0};
+    juce::String noteText_;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VisualizerPage)
+};
+
 /**
  *
  *  @class   TabbedComp
@@ -137,6 +274,7 @@ private:
     juce::Viewport audioSetupViewport_;
     AudioSetupPage audioSetupPage_;
     AppSettingsPage appSettingsPage_;
+    VisualizerPage visualizerPage_;
     DebugPage debugPage_;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TabbedComp)
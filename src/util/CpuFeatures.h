@@ -0,0 +1,57 @@
+/**
+ *
+ *  @file      CpuFeatures.h
+ *  @brief     Instruction set detection for runtime kernel dispatch.
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+// Functions marked with ANYMIDI_TARGET are compiled for the given instruction
+// set regardless of the compiler flags, and must only be called when
+// getSimdLevel() reports support for it.
+#if JUCE_INTEL && (JUCE_GCC || JUCE_CLANG)
+#define ANYMIDI_TARGET(isa) __attribute__((target(isa)))
+#define ANYMIDI_MULTIVERSION 1
+#else
+#define ANYMIDI_MULTIVERSION 0
+#endif
+
+namespace anyMidi {
+
+enum class SimdLevel { Generic, AVX2, AVX512 };
+
+/**
+ *  @brief  Widest instruction set with a compiled kernel that the CPU
+ *          supports.
+ */
+inline SimdLevel getSimdLevel() {
+#if ANYMIDI_MULTIVERSION
+    if (juce::SystemStats::hasAVX512F()) {
+        return SimdLevel::AVX512;
+    }
+    if (juce::SystemStats::hasAVX2() && juce::SystemStats::hasFMA3()) {
+        return SimdLevel::AVX2;
+    }
+#endif
+    return SimdLevel::Generic;
+}
+
+inline const char *getSimdLevelName(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::AVX512:
+        return "AVX-512";
+    case SimdLevel::AVX2:
+        return "AVX2";
+    case SimdLevel::Generic:
+        break;
+    }
+    return "generic";
+}
+
+} // namespace anyMidi
@@ -0,0 +1,151 @@
+/**
+ *
+ *  @file      Logger.cpp
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#include "Logger.h"
+#include "Globals.h"
+
+const char *anyMidi::getLogLevelName(const LogLevel level) {
+    switch (level) {
+    case LogLevel::Debug:
+        return "DEBUG";
+    case LogLevel::Info:
+        return "INFO";
+    case LogLevel::Warning:
+        return "WARNING";
+    case LogLevel::Error:
+        return "ERROR";
+    }
+    return "";
+}
+
+anyMidi::Logger &anyMidi::Logger::getInstance() {
+    static Logger instance;
+    return instance;
+}
+
+anyMidi::LogDrainer::LogDrainer(const juce::ValueTree &v)
+    : tree_{v}, startTicks_{juce::Time::getHighResolutionTicks()},
+      startMillis_{juce::Time::currentTimeMillis()} {
+    startTimerHz(drainRateHz);
+}
+
+anyMidi::LogDrainer::~LogDrainer() {
+    stopTimer();
+    drain();
+}
+
+void anyMidi::LogDrainer::enableLogFile(const juce::File &file,
+                                        juce::int64 maxBytes, int maxFiles) {
+    logFile_ = file;
+    maxLogBytes_ = maxBytes;
+    maxLogFiles_ = maxFiles;
+
+    logStream_ = std::make_unique<juce::FileOutputStream>(logFile_);
+    if (logStream_->failedToOpen()) {
+        logStream_ = nullptr;
+        anyMidi::log(LogLevel::Error, "Failed to open log file {}",
+                     logFile_.getFullPathName().toRawUTF8());
+    }
+}
+
+void anyMidi::LogDrainer::timerCallback() { drainBatch(); }
+
+void anyMidi::LogDrainer::drain() {
+    while (drainBatch()) {
+    }
+}
+
+bool anyMidi::LogDrainer::drainBatch() {
+    juce::StringArray lines;
+    LogRecord record;
+
+    for (int i = 0; i < maxRecordsPerDrain && Logger::getInstance().read(record);
+         ++i) {
+        lines.add(formatRecord(record));
+    }
+
+    const auto dropped = Logger::getInstance().takeNumDropped();
+    if (dropped > 0) {
+        lines.add("Log ring full, dropped " + juce::String(dropped) +
+                  " messages.");
+    }
+
+    if (lines.isEmpty()) {
+        return false;
+    }
+
+    const juce::String batch = lines.joinIntoString(juce::newLine);
+    writeToFile(batch + juce::newLine);
+
+    auto guiNode = tree_.getRoot().getChildWithName(anyMidi::GUI_ID);
+    if (guiNode.getProperty(anyMidi::LOG_ID) == juce::var(batch)) {
+        // Setting an equal value doesn't notify listeners.
+        guiNode.sendPropertyChangeMessage(anyMidi::LOG_ID);
+    } else {
+        guiNode.setProperty(anyMidi::LOG_ID, batch, nullptr);
+    }
+    return true;
+}
+
+juce::String
+anyMidi::LogDrainer::formatRecord(const LogRecord &record) const {
+    constexpr double msPerSecond{1000.0};
+    const auto millis =
+        startMillis_ +
+        static_cast<juce::int64>(juce::Time::highResolutionTicksToSeconds(
+                                     record.ticks - startTicks_) *
+                                 msPerSecond);
+    const juce::Time time{millis};
+
+    constexpr int msDigits{3};
+    return time.formatted("%H:%M:%S.") +
+           juce::String(time.getMilliseconds()).paddedLeft('0', msDigits) +
+           " " + getLogLevelName(record.level) + ": " +
+           juce::String::fromUTF8(record.message.data(),
+                                  static_cast<int>(record.length));
+}
+
+void anyMidi::LogDrainer::writeToFile(const juce::String &text) {
+    if (logStream_ == nullptr) {
+        return;
+    }
+
+    logStream_->writeText(text, false, false, nullptr);
+    logStream_->flush();
+
+    if (logStream_->getPosition() >= maxLogBytes_) {
+        rotateLogFile();
+    }
+}
+
+void anyMidi::LogDrainer::rotateLogFile() {
+    logStream_ = nullptr;
+
+    const auto backup = [this](int index) {
+        return logFile_.getSiblingFile(logFile_.getFileNameWithoutExtension() +
+                                       "." + juce::String(index) +
+                                       logFile_.getFileExtension());
+    };
+
+    // Shifts anyMidi.1.log -> anyMidi.2.log and so on, discarding the oldest.
+    backup(maxLogFiles_).deleteFile();
+    for (int i = maxLogFiles_ - 1; i > 0; --i) {
+        backup(i).moveFileTo(backup(i + 1));
+    }
+    if (maxLogFiles_ > 0) {
+        logFile_.moveFileTo(backup(1));
+    } else {
+        logFile_.deleteFile();
+    }
+
+    logStream_ = std::make_unique<juce::FileOutputStream>(logFile_);
+    if (logStream_->failedToOpen()) {
+        logStream_ = nullptr;
+    }
+}
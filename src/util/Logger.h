@@ -0,0 +1,195 @@
+/**
+ *
+ *  @file      Logger.h
+ *  @brief     Real-time safe logging to the debug tab and an optional file.
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <format>
+
+#include <juce_core/juce_core.h>
+#include <juce_data_structures/juce_data_structures.h>
+#include <juce_events/juce_events.h>
+
+#include "MpscQueue.h"
+
+namespace anyMidi {
+
+enum class LogLevel : std::uint8_t { Debug, Info, Warning, Error };
+
+/**
+ *  @brief  Human readable name of a log level.
+ */
+const char *getLogLevelName(LogLevel level);
+
+/**
+ *
+ *  @struct  LogRecord
+ *  @brief   Fixed size log entry. Messages longer than the record are
+ *           truncated rather than allocated.
+ *
+ */
+struct LogRecord {
+    static constexpr std::size_t maxMessageLength{192};
+
+    juce::int64 ticks{0}; /// High resolution ticks at time of logging.
+    LogLevel level{LogLevel::Info};
+    std::uint16_t length{0};
+    std::array<char, maxMessageLength> message{};
+};
+
+/**
+ *
+ *  @class   Logger
+ *  @brief   Process wide sink for log records. Writing formats into a
+ *           preallocated ring slot and never allocates, locks or touches GUI
+ *           objects, so it is safe to call from the audio thread. Records are
+ *           handed to the GUI and log file by a LogDrainer on the message
+ *           thread.
+ *
+ */
+class Logger {
+public:
+    static Logger &getInstance();
+
+    /**
+     *  @brief Formats and queues a message. If the ring is full the message
+     *         is dropped and counted.
+     *  @param level - Severity of the message.
+     *  @param fmt   - std::format format string.
+     *  @param args  - Format arguments.
+     */
+    template <typename... Args>
+    void write(LogLevel level, std::format_string<Args...> fmt,
+               Args &&...args) noexcept {
+        const auto ticks = juce::Time::getHighResolutionTicks();
+        const bool pushed = queue_.tryPushWith([&](LogRecord &record) {
+            record.ticks = ticks;
+            record.level = level;
+            try {
+                const auto result = std::format_to_n(
+                    record.message.data(),
+                    static_cast<std::ptrdiff_t>(record.message.size()), fmt,
+                    std::forward<Args>(args)...);
+                record.length = static_cast<std::uint16_t>(std::min(
+                    static_cast<std::size_t>(result.size),
+                    record.message.size()));
+            } catch (...) {
+                record.length = 0;
+            }
+        });
+
+        if (!pushed) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     *  @brief  Pops the oldest record. Only the drainer may call this.
+     *  @param  record - Destination of the record.
+     *  @retval        - False if there was nothing to read.
+     */
+    bool read(LogRecord &record) noexcept { return queue_.tryPop(record); }
+
+    /**
+     *  @brief  Returns and resets the number of records dropped due to a full
+     *          ring since last call.
+     */
+    juce::uint32 takeNumDropped() noexcept {
+        return dropped_.exchange(0, std::memory_order_relaxed);
+    }
+
+private:
+    Logger() = default;
+
+    static constexpr std::size_t ringCapacity{1024};
+
+    MpscQueue<LogRecord, ringCapacity> queue_;
+    std::atomic<juce::uint32> dropped_{0};
+
+    JUCE_DECLARE_NON_COPYABLE(Logger)
+};
+
+/**
+ *  @brief Logs a formatted message to the debug tab. Real-time safe.
+ *  @param level - Severity of the message.
+ *  @param fmt   - std::format format string.
+ *  @param args  - Format arguments. juce::String has to be passed as raw
+ *                 UTF-8, e.g. with toRawUTF8().
+ */
+template <typename... Args>
+inline void log(LogLevel level, std::format_string<Args...> fmt,
+                Args &&...args) noexcept {
+    Logger::getInstance().write(level, fmt, std::forward<Args>(args)...);
+}
+
+/**
+ *
+ *  @class   LogDrainer
+ *  @brief   Periodically moves queued log records into the log property of
+ *           the GUI node on the message thread, optionally writing them to a
+ *           rotating log file as well.
+ *
+ */
+class LogDrainer : private juce::Timer {
+public:
+    explicit LogDrainer(const juce::ValueTree &v);
+    ~LogDrainer() override;
+
+    /**
+     *  @brief Enables writing log records to file. When the file grows past
+     *         the size limit it is rotated into numbered backups.
+     *  @param file     - Log file to append to.
+     *  @param maxBytes - Size at which the file is rotated.
+     *  @param maxFiles - Number of rotated backups to keep.
+     */
+    void enableLogFile(const juce::File &file, juce::int64 maxBytes,
+                       int maxFiles);
+
+    /**
+     *  @brief Empties the ring immediately.
+     */
+    void drain();
+
+private:
+    void timerCallback() override;
+
+    /**
+     *  @brief  Moves up to maxRecordsPerDrain records to the GUI and log file.
+     *  @retval  - False if there was nothing to move.
+     */
+    bool drainBatch();
+
+    juce::String formatRecord(const LogRecord &record) const;
+
+    void writeToFile(const juce::String &text);
+    void rotateLogFile();
+
+    static constexpr int drainRateHz{30};
+    /// Upper limit of records moved per timer tick, so a flood of messages
+    /// can't stall the message thread.
+    static constexpr int maxRecordsPerDrain{256};
+
+    juce::ValueTree tree_;
+
+    /// Wall clock and tick counter sampled together, for converting record
+    /// ticks to time of day.
+    const juce::int64 startTicks_;
+    const juce::int64 startMillis_;
+
+    juce::File logFile_;
+    std::unique_ptr<juce::FileOutputStream> logStream_;
+    juce::int64 maxLogBytes_{0};
+    int maxLogFiles_{0};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LogDrainer)
+};
+
+} // namespace anyMidi
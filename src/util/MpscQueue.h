@@ -0,0 +1,124 @@
+/**
+ *
+ *  @file      MpscQueue.h
+ *  @brief     Bounded lock-free multi-producer single-consumer queue.
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace anyMidi {
+
+/// Size of a cache line, used to keep frequently written atomics apart.
+constexpr std::size_t cacheLineSize{64};
+
+/**
+ *
+ *  @class   MpscQueue
+ *  @brief   Fixed capacity ring of preallocated elements. Any number of
+ *           threads may push, a single thread may pop. Neither operation
+ *           allocates or blocks, which makes it usable from the audio thread.
+ *
+ *           Based on Dmitry Vyukov's bounded MPMC queue, where every slot
+ *           carries a sequence number telling whether it is free or filled.
+ *  @tparam  T        - Element type. Must be default constructible.
+ *  @tparam  Capacity - Number of slots. Must be a power of two.
+ *
+ */
+template <typename T, std::size_t Capacity> class MpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "Capacity must be a power of two.");
+
+public:
+    MpscQueue() {
+        for (std::size_t i = 0; i < Capacity; ++i) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     *  @brief  Claims a free slot and lets the caller fill it in place.
+     *  @param  fill - Callable taking a T& which writes the element.
+     *  @retval      - False if the queue was full and nothing was pushed.
+     */
+    template <typename Fill> bool tryPushWith(Fill &&fill) noexcept {
+        std::size_t pos = writePos_.load(std::memory_order_relaxed);
+        Slot *slot{nullptr};
+
+        for (;;) {
+            slot = &slots_[pos & mask];
+            const std::size_t seq =
+                slot->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(seq) -
+                              static_cast<std::ptrdiff_t>(pos);
+
+            if (diff == 0) {
+                if (writePos_.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false; // Full
+            } else {
+                pos = writePos_.load(std::memory_order_relaxed);
+            }
+        }
+
+        fill(slot->value);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     *  @brief  Pushes a copy of an element.
+     *  @param  value - Element to push.
+     *  @retval       - False if the queue was full.
+     */
+    bool tryPush(const T &value) noexcept {
+        return tryPushWith([&value](T &slot) { slot = value; });
+    }
+
+    /**
+     *  @brief  Pops the oldest element. Only to be called from one thread.
+     *  @param  out - Destination of the popped element.
+     *  @retval     - False if the queue was empty.
+     */
+    bool tryPop(T &out) noexcept {
+        Slot &slot = slots_[readPos_ & mask];
+        const std::size_t seq = slot.sequence.load(std::memory_order_acquire);
+
+        if (static_cast<std::ptrdiff_t>(seq) -
+                static_cast<std::ptrdiff_t>(readPos_ + 1) <
+            0) {
+            return false; // Empty, or producer still writing.
+        }
+
+        out = slot.value;
+        slot.sequence.store(readPos_ + Capacity, std::memory_order_release);
+        ++readPos_;
+        return true;
+    }
+
+    static constexpr std::size_t getCapacity() { return Capacity; }
+
+private:
+    static constexpr std::size_t mask{Capacity - 1};
+
+    struct Slot {
+        std::atomic<std::size_t> sequence{0};
+        T value{};
+    };
+
+    std::array<Slot, Capacity> slots_;
+    alignas(cacheLineSize) std::atomic<std::size_t> writePos_{0};
+    alignas(cacheLineSize) std::size_t readPos_{0};
+};
+
+} // namespace anyMidi
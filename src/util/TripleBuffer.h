@@ -0,0 +1,79 @@
+/**
+ *
+ *  @file      TripleBuffer.h
+ *  @brief     Lock-free single producer, single consumer triple buffer.
+ *  @author    Hallvard Jensen
+ *  @date      18 Oct 2026
+ *  @copyright Hallvard Jensen, 2026. All right reserved.
+ *
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+
+#include "MpscQueue.h"
+
+namespace anyMidi {
+
+/**
+ *
+ *  @class   TripleBuffer
+ *  @brief   Hands the latest of a series of values from one thread to
+ *           another without locking or copying. The writer fills a back
+ *           buffer and publishes it by swapping it with a shared middle
+ *           buffer. The reader swaps the middle buffer into its front buffer
+ *           when it is newer. Values published faster than they are read are
+ *           skipped.
+ *  @tparam  T - Value type. Must be default constructible.
+ *
+ */
+template <typename T> class TripleBuffer {
+public:
+    /**
+     *  @brief  Buffer the writer may fill. Not visible to the reader until
+     *          publish() is called.
+     */
+    T &getWriteBuffer() noexcept { return buffers_[writeIndex_]; }
+
+    /**
+     *  @brief Makes the write buffer the latest value and takes a new one.
+     */
+    void publish() noexcept {
+        writeIndex_ = middle_.exchange(writeIndex_ | dirtyBit,
+                                       std::memory_order_acq_rel) &
+                      indexMask;
+    }
+
+    /**
+     *  @brief  Takes the latest published value if there is one the reader
+     *          hasn't seen.
+     *  @retval  - True if the read buffer changed.
+     */
+    bool update() noexcept {
+        if ((middle_.load(std::memory_order_relaxed) & dirtyBit) == 0) {
+            return false;
+        }
+        readIndex_ =
+            middle_.exchange(readIndex_, std::memory_order_acq_rel) &
+            indexMask;
+        return true;
+    }
+
+    /**
+     *  @brief  Latest value taken by update().
+     */
+    const T &getReadBuffer() const noexcept { return buffers_[readIndex_]; }
+
+private:
+    static constexpr int dirtyBit{4};
+    static constexpr int indexMask{3};
+
+    std::array<T, 3> buffers_{};
+    int writeIndex_{0};
+    alignas(cacheLineSize) std::atomic<int> middle_{1};
+    alignas(cacheLineSize) int readIndex_{2};
+};
+
+} // namespace anyMidi